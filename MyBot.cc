@@ -7,11 +7,13 @@
 #include <iostream>
 #include <cmath>
 #include <set>
+#include <limits>
 
 #include "order.h"
 #include "planet.h"
 #include "player.h"
-#include "knapsackTarget.h"
+#include "knapsack.h"
+#include "simulationcache.h"
 #include "sys/time.h"
 
 using std::min;
@@ -24,10 +26,44 @@ using std::endl;
 MyBot::MyBot(Game* game) :
     AbstractBot(game),
     logging(false),
-    maxTime(1.0)
+    rollouts(false),
+    rolloutCandidates(4),
+    rolloutsCount(200),
+    rolloutDepth(30),
+    matrixGameMode(NoMatrixGame),
+    matrixGameResponses(6),
+    payoffCacheVersion(-1),
+    matrixGameRandom(1),
+    endgameTurns(10),
+    endgameTargets(3),
+    endgameMaxCombinations(20000),
+    frontierProximityValid(false),
+    maxTime(1.0),
+    firstTurnMaxTime(3.0),
+    beamWidth(1)
 {
 }
 
+void MyBot::enableRollouts(int threadsCount) {
+    rolloutEvaluator.setThreadsCount(threadsCount);
+    rollouts = true;
+}
+
+void MyBot::enableMatrixGame(bool mixedStrategy) {
+    matrixGameMode = mixedStrategy ? MixedMatrixGame : MaximinMatrixGame;
+}
+
+void MyBot::setEndgameTurns(int turns) {
+    endgameTurns = turns;
+}
+
+void MyBot::setBeamWidth(int width) {
+    beamWidth = width;
+}
+
+void MyBot::setFirstTurnMaxTime(double seconds) {
+    firstTurnMaxTime = seconds;
+}
 
 //the entry function, this is called by the game engine
 void MyBot::executeTurn() {
@@ -36,11 +72,15 @@ void MyBot::executeTurn() {
     if(logging){
         cerr << "#########################################" << endl;
         cerr << "Turn: " << game->turn() << endl;
+        cerr << "New enemy fleets: " << game->newEnemyFleets().size() << " of " << game->enemyFleets().size() << endl;
     }
 
   
     if (game->turn() == 1) {
         initialize();
+        //the rest of the first turn has the time of a normal turn
+        gettimeofday(&tim, NULL);
+        t1=tim.tv_sec+(tim.tv_usec/1000000.0);
         preprocessing();
         myStartingPlanet = myPlanets[0];
         enemyStartingPlanet = enemyPlanets[0];
@@ -66,17 +106,23 @@ void MyBot::executeTurn() {
         return;
     } 
 
-
-
+    if (turnsRemaining < endgameTurns && endgame()) {
+        return;
+    }
 
     const int maxActions = 5;
-    for(int actions(0); actions != maxActions; ++actions) {
-        //find a good action and execute it, if possible
-        if (!chooseAction()) { 
-            break; //stop if no good action can be found
+    if (beamWidth > 1) {
+        chooseActions(maxActions);
+    } else {
+        for(int actions(0); actions != maxActions; ++actions) {
+            //find a good action and execute it, if possible
+            if (!chooseAction()) { 
+                break; //stop if no good action can be found
+            }
         }
     }
 
+    expand();
 
     updatePredictions();
     //sent available ships towards the frontier
@@ -123,6 +169,8 @@ void MyBot::executeTurn() {
         }
     }
     if(logging){
+        const SimulationCache& cache = game->snapshot().simulationCache();
+        cerr << "simulation cache: " << cache.hits() << " hits of " << cache.lookups() << " lookups" << endl;
         cerr << "Turn finished" << endl;
     }
 }
@@ -130,31 +178,73 @@ void MyBot::executeTurn() {
 
 //this function is called only in turn 1, 
 //and can be used for computing static properties of the map
+//The engine gives more time in the first turn, so everything that only depends on the map is computed here.
+//The game has already done its part of the analysis when it read the map. The analysis may use 70% of the time the
+//first turn has on top of a normal turn, the optional steps are skipped once that is used up.
 void MyBot::initialize() {
     if(logging){
         cerr << "initializing..." << endl;
+        cerr << "simulation kernel: " << BatchSimulator::kernelName(batchSimulator.kernel()) << endl;
     }
+    analysisTimes = game->mapAnalysisTimes();
+    double start = elapsed();
+    const double budget = (firstTurnMaxTime - maxTime)*0.7;
     //calculate the size of the map, defined as the maximum distance between two planets
-    maxDistanceBetweenPlanets = 1;
-    const Planets planets = game->planets();
-    for(Planets::const_iterator pit1 = planets.begin(); pit1!= planets.end();++pit1) {
-        Planet* p1 = *pit1;
-        for(Planets::const_iterator pit2 = planets.begin(); pit2!= planets.end();++pit2) {
-            Planet* p2 = *pit2;
-            int dist = p1->distance(p2);
-            if (dist > maxDistanceBetweenPlanets) {
-                maxDistanceBetweenPlanets = dist;
-            }
-        }
-    }
+    const vector<int>& distances = game->snapshot().distances();
+    maxDistanceBetweenPlanets = max(1, *std::max_element(distances.begin(), distances.end()));
     enemy = game->playerByID(2);
     me = game->playerByID(1);
+    addAnalysisTime("size of the map", start);
+    //the static tables come from the map cache if this map has been played before
+    computeProtection();
+    addAnalysisTime("protection", start);
+    //the protection tables are needed in every turn, the rest is optional
+    if(analysisTime() <= budget){
+        computeOnTheWay();
+        addAnalysisTime("on the way", start);
+    }
+    if(analysisTime() <= budget){
+        game->mapCache().save();
+        addAnalysisTime("saving the map cache", start);
+    }
+
+    double total = analysisTime();
     if(logging){
+        cerr << "turn 1 analysis:" << endl;
+        for(Game::Timings::const_iterator it = analysisTimes.begin(); it != analysisTimes.end(); ++it) {
+            cerr << "  " << it->first << ": " << it->second * 1000 << "ms" << endl;
+        }
+        cerr << "  total: " << total * 1000 << "ms of " << budget * 1000 << "ms" << endl;
         cerr << "max distance between planets: " << maxDistanceBetweenPlanets << endl;
+        cerr << (game->symmetric() ? "symmetric map" : "map is not symmetric") << endl;
+        if(total > budget){
+            cerr << "turn 1 analysis took " << total << "s, the budget is " << budget << "s" << endl;
+        }
         cerr << "initializing finished" << endl;
     }
 }
 
+//seconds since the start of the turn
+double MyBot::elapsed() {
+    gettimeofday(&tim, NULL);
+    return tim.tv_sec+(tim.tv_usec/1000000.0) - t1;
+}
+
+void MyBot::addAnalysisTime(const string& name, double& start) {
+    double end = elapsed();
+    analysisTimes.push_back(std::make_pair(name, end - start));
+    start = end;
+}
+
+//seconds spent on the analysis of the map so far, by the game and the bot
+double MyBot::analysisTime() const {
+    double total(0);
+    for(Game::Timings::const_iterator it = analysisTimes.begin(); it != analysisTimes.end(); ++it) {
+        total += it->second;
+    }
+    return total;
+}
+
 
 //this updates the things that change from turn to turn, and makes predictions on planets future states
 void MyBot::preprocessing() {
@@ -163,18 +253,35 @@ void MyBot::preprocessing() {
     }
     const int turnLimit = 200; //according to the contest organizators, this will probably continue to be the turn limit until the end of the contest.
     turnsRemaining = turnLimit - game->turn();
+    //with more than one enemy, the heuristics compare with the strongest one
+    enemy = game->playerByID(EnemyID);
+    for(uint id(EnemyID + 1); id < game->playersCount(); ++id){
+        Player* player = game->playerByID(id);
+        if(player->shipsCount() > enemy->shipsCount()){
+            enemy = player;
+        }
+    }
     myPlanets = game->myPlanets();
     notMyPlanets = game->notMyPlanets();
     enemyPlanets = game->enemyPlanets();
     neutralPlanets = game->neutralPlanets();
     planets = game->planets();
+    updateOwnerProximity();
+    updateOwnerMasks();
+    frontierPlanets.resize(planets.size());
+    for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
+        if ((*pit)->frontierStatus) {
+            frontierPlanets.insert((*pit)->planetID());
+        }
+    }
+    frontierProximityValid = false;
     lookahead = maxDistanceBetweenPlanets;
   
     updatePredictions();
     for(Planets::const_iterator pit = myPlanets.begin();pit!=myPlanets.end();++pit) {
         Planet* p = *pit;
         if(logging){
-            cerr << p->planetID() << ": comp: " << shipsAvailable(competitivePredictions[p], lookahead) << "; static: " << shipsAvailable(predictions[p], lookahead) <<  endl;
+            cerr << p->planetID() << ": comp: " << shipsAvailable(competitivePredictions[p->planetID()], lookahead) << "; static: " << shipsAvailable(predictions[p->planetID()], lookahead) <<  endl;
         }
     }
     if(logging){
@@ -187,33 +294,40 @@ void MyBot::updatePredictions(){
     if(logging){
         cerr << "updating predictions..." << endl;
     }
-    predictions.clear();
-    competitivePredictions.clear();
-    worstCasePredictions.clear();
-    maxOutgoingFleets.clear();
+    const Snapshot& snapshot = game->snapshot();
+    maxOutgoingFleets.resize(planets.size());
     //static predictions taking into account only current fleet movements
-    for(Planets::const_iterator pit = planets.begin();pit!=planets.end();++pit) {
-        Planet* p = *pit;
-        predictions[p] = p->getPredictions(lookahead);
-    }
+    batchSimulator.reset(snapshot, lookahead);
+    batchSimulator.run(predictions);
     if(logging){
         cerr << "updated static predictions..." << endl;
     }
 
     for(Planets::const_iterator pit = planets.begin();pit!=planets.end();++pit) {
         Planet* p = *pit;
-        maxOutgoingFleets[p] = computeMaxOutgoingFleets(p);
+        snapshot.simulateMaxOutgoing(p->planetID(), lookahead + 1, maxOutgoingFleets[p->planetID()]);
     }
     if(logging){
         cerr << "updated max outgoing fleets..." << endl;
     }
 
     //special-case predictions for each planet. It is important that the static predictions happen before this.
+    FleetEvents events;
+    batchSimulator.reset(snapshot, lookahead);
+    for(Planets::const_iterator pit = planets.begin();pit!=planets.end();++pit) {
+        Planet* p = *pit;
+        worstCaseFleets(p, events);
+        batchSimulator.addEvents(p->planetID(), events);
+    }
+    batchSimulator.run(worstCasePredictions);
+
+    batchSimulator.reset(snapshot, lookahead);
     for(Planets::const_iterator pit = planets.begin();pit!=planets.end();++pit) {
         Planet* p = *pit;
-        worstCasePredictions[p] = p->getPredictions(lookahead, worstCaseFleets(p));
-        competitivePredictions[p] = p->getPredictions(lookahead, competitiveFleets(p));
+        competitiveFleets(p, events);
+        batchSimulator.addEvents(p->planetID(), events);
     }
+    batchSimulator.run(competitivePredictions);
     if(logging){
         cerr << "updated competitive and worst-case predictions..." << endl;
     }
@@ -225,11 +339,12 @@ void MyBot::updatePredictions(){
         Planet* p = *pit;
         p->predictedMine = false;
         p->predictedEnemy = false;
+        const Timeline& preds = predictions[p->planetID()];
         for(int i(0); i != lookahead + 1; ++i){
-            if (predictions[p][i].owner()->isMe()) {
+            if (preds.isMine(i)) {
                 p->predictedMine = true;
             }
-            if (predictions[p][i].owner()->isEnemy()) {
+            if (preds.isEnemy(i)) {
                 p->predictedEnemy = true;
             }
         }
@@ -238,10 +353,7 @@ void MyBot::updatePredictions(){
         cerr << "updated \"predicted mine\"..." << endl;
     }
 
-    for(Planets::const_iterator pit = planets.begin();pit!=planets.end();++pit) {
-        Planet* p = *pit;
-        p->frontierStatus = isFrontier(p);
-    }
+    updateFrontier();
     if(logging){
         cerr << "updated frontier planets..." << endl;
     }
@@ -265,10 +377,11 @@ void MyBot::openingTurn() {
     vector<KnapsackTarget> candidates;
     for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
         Planet* p = *pit;
-        if (!predictions[p][lookahead].owner()->isMe() && p->distance(myStartingPlanet) < p->distance(enemyStartingPlanet)) {
+        if (!predictions[p->planetID()].isMine(lookahead) && p->distance(myStartingPlanet) < p->distance(enemyStartingPlanet)) {
             KnapsackTarget kt;
-            kt.p = predictions[p][p->distance(myStartingPlanet)];
-            kt.weight = kt.p.shipsCount() + 1;
+            kt.p = p;
+            kt.t = p->distance(myStartingPlanet);
+            kt.weight = predictions[p->planetID()].shipsCount(kt.t) + 1;
             candidates.push_back(kt);
             if(logging){
                 cerr << "added knapsack candidate: planet " << p->planetID() << endl;
@@ -276,21 +389,22 @@ void MyBot::openingTurn() {
         }
     }
     for(vector<KnapsackTarget>::iterator kt = candidates.begin(); kt != candidates.end(); ++kt) {
-        kt->value = kt->p.growthRate()*(maxDistanceBetweenPlanets - kt->p.distance(myStartingPlanet)); 
+        kt->value = kt->p->growthRate()*(maxDistanceBetweenPlanets - kt->p->distance(myStartingPlanet)); 
     }
     
-    int sa = shipsAvailable(competitivePredictions[myStartingPlanet], lookahead);
+    int sa = shipsAvailable(competitivePredictions[myStartingPlanet->planetID()], lookahead);
     int maxWeight = sa;
       
-    vector<KnapsackTarget> targets = knapsack01(candidates,maxWeight);
+    vector<KnapsackTarget> targets;
+    knapsack.solve(candidates, maxWeight, targets);
     if(logging){
         cerr << "Knapsack01 found " << targets.size() << " targets" << endl;
     }
     for(vector<KnapsackTarget>::const_iterator kt = targets.begin(); kt != targets.end(); ++kt) {
         if(logging){
-            cerr << "knapsack target: " << kt->p.planetID() << endl;
+            cerr << "knapsack target: " << kt->p->planetID() << endl;
         }
-        Planet* p = game->planetByID(kt->p.planetID());
+        Planet* p = kt->p;
         if(kt->weight <= sa){
             Order o(myStartingPlanet, p, kt->weight); 
             issueOrder(o, "opening turn knapsack move.");
@@ -301,6 +415,59 @@ void MyBot::openingTurn() {
     }
 }
 
+//Mid-game expansion: the spare ships of each planet behind the frontier are allocated to the neutral planets
+//closer to it than to the enemy, again by solving a knapsack01-problem. chooseAction() only takes one target at a time,
+//this finds the best set of targets for the ships of a planet. Every target still has to pass the evaluation of its orders.
+void MyBot::expand() {
+    if(logging){
+        cerr << "expansion started..." << endl;
+    }
+    updatePredictions();
+    vector<KnapsackTarget> candidates;
+    vector<KnapsackTarget> targets;
+    for(Planets::const_iterator sit = myPlanets.begin(); sit != myPlanets.end(); ++sit) {
+        Planet* source = *sit;
+        if(elapsed() > maxTime*0.7)
+            break;
+        if(source->frontierStatus)
+            continue;
+        int sa = min(shipsAvailable(predictions[source->planetID()], lookahead), shipsAvailable(competitivePredictions[source->planetID()], lookahead));
+        if(sa <= 0)
+            continue;
+        candidates.clear();
+        for(Planets::const_iterator pit = neutralPlanets.begin(); pit != neutralPlanets.end(); ++pit) {
+            Planet* p = *pit;
+            int t = p->distance(source);
+            if (p->growthRate() > 0 && t < lookahead && predictions[p->planetID()].isNeutral(t)
+                && t < p->distance(nearestEnemyPlanet(p)) && nearestFriendlyPlanet(p) == source) {
+                KnapsackTarget kt;
+                kt.p = p;
+                kt.t = t;
+                kt.weight = predictions[p->planetID()].shipsCount(t) + 1;
+                kt.value = p->growthRate()*(maxDistanceBetweenPlanets - t);
+                candidates.push_back(kt);
+            }
+        }
+        knapsack.solve(candidates, sa, targets);
+        if(targets.empty())
+            continue;
+        vector<Orders> orders;
+        for(vector<KnapsackTarget>::const_iterator kt = targets.begin(); kt != targets.end(); ++kt) {
+            orders.push_back(Orders(1, Order(source, kt->p, kt->weight)));
+        }
+        vector<int> orderValues;
+        values(orders, orderValues);
+        for(int i(0); i != orders.size(); ++i) {
+            if(orderValues[i] > 0){
+                issueOrders(orders[i]);
+            }
+        }
+        updatePredictions();
+    }
+    if(logging){
+        cerr << "expansion finished" << endl;
+    }
+}
 
 //tries to find a good action and executes it, returns true on success.
 bool MyBot::chooseAction() {
@@ -314,32 +481,19 @@ bool MyBot::chooseAction() {
 
     updatePredictions();
     vector<Orders> orderCandidates;
-    for(Planets::const_iterator p1 = myPlanets.begin(); p1!= myPlanets.end(); ++p1) {
-        Planet* source1 = *p1;
-        int i(0);
-        if(source1->shipsCount() > 0){
-            for(Planets::const_iterator p2 = myPlanets.begin(); p2!= myPlanets.end() && i<10; ++p2) {
-                Planet* source2 = *p2;
-                if(source2->shipsCount() > 0 && source1->planetID() <= source2->planetID()){
-                    addOrderCandidates(source1, source2, orderCandidates);
-                    ++i;
-                }
-            }
-        }
-    }
+    addAllOrderCandidates(orderCandidates);
     if(logging){
         cerr << "added all action candidates (" << orderCandidates.size() << ")" << endl;
     }
     //find the best action candidate:
+    vector<int> candidateValues;
+    if(!values(orderCandidates, candidateValues))
+        return false;
     int maxValue = 0;
     Orders* maxOrders(0);
     for(vector<Orders>::iterator oit = orderCandidates.begin(); oit != orderCandidates.end(); ++oit) {
-        gettimeofday(&tim, NULL);
-        double t2=tim.tv_sec+(tim.tv_usec/1000000.0);
-        if((t2-t1)>maxTime*0.7)
-            return false;
         Orders* o=&*oit;
-        int newValue = value(*o, false);
+        int newValue = candidateValues[oit - orderCandidates.begin()];
         if(logging){
             cerr << "evaluated the following orders: " << endl;
             logOrders(*o);
@@ -350,6 +504,24 @@ bool MyBot::chooseAction() {
             maxOrders = o; 
         }
     }
+    if (searchCandidates() && maxOrders) {
+        vector<pair<int, int> > ranked;
+        for(int i(0); i != orderCandidates.size(); ++i){
+            if(candidateValues[i] > 0){
+                ranked.push_back(make_pair(-candidateValues[i], i));
+            }
+        }
+        sort(ranked.begin(), ranked.end());
+        ranked.resize(min<int>(ranked.size(), rolloutCandidates));
+        vector<Orders> best;
+        for(vector<pair<int, int> >::const_iterator rit = ranked.begin(); rit != ranked.end(); ++rit){
+            best.push_back(orderCandidates[rit->second]);
+        }
+        int b = bestCandidate(best);
+        if (b >= 0) {
+            maxOrders = &orderCandidates[ranked[b].second];
+        }
+    }
     
     //execute the order with the highest value:
     if (maxValue>0 && maxOrders) {
@@ -371,6 +543,489 @@ bool MyBot::chooseAction() {
     }
 }
 
+//the action candidates for all pairs of my planets with ships
+void MyBot::addAllOrderCandidates(vector<Orders>& orderCandidates){
+    for(Planets::const_iterator p1 = myPlanets.begin(); p1!= myPlanets.end(); ++p1) {
+        Planet* source1 = *p1;
+        int i(0);
+        if(source1->shipsCount() > 0){
+            for(Planets::const_iterator p2 = myPlanets.begin(); p2!= myPlanets.end() && i<10; ++p2) {
+                Planet* source2 = *p2;
+                if(source2->shipsCount() > 0 && source1->planetID() <= source2->planetID()){
+                    addOrderCandidates(source1, source2, orderCandidates);
+                    ++i;
+                }
+            }
+        }
+    }
+}
+
+bool MyBot::betterBeamState(const BeamState& s1, const BeamState& s2){
+    return s1.value > s2.value;
+}
+
+//Finds a set of up to maxActions actions with a beam search and executes it. Unlike the greedy rounds of chooseAction(),
+//this can find actions that are only good together. The best actions are evaluated on their own first, then sets of them are
+//built up one action at a time. Each action is evaluated on top of the fleet events of the actions already in the set,
+//and only the beamWidth best sets are extended further. Late in the turn the beam narrows, and when the time is up
+//the best set found so far is executed.
+//Returns true if any action was executed.
+bool MyBot::chooseActions(int maxActions){
+    if(logging){
+        cerr << "started chooseActions..." << endl;
+    }
+    if(elapsed() > maxTime*0.7)
+        return false;
+    updatePredictions();
+    vector<Orders> orderCandidates;
+    addAllOrderCandidates(orderCandidates);
+    vector<int> candidateValues;
+    values(orderCandidates, candidateValues);
+
+    //the candidates to build the sets from, best first
+    vector<pair<int, int> > ranked;
+    for(int i(0); i != orderCandidates.size(); ++i){
+        if(candidateValues[i] > 0){
+            ranked.push_back(make_pair(-candidateValues[i], i));
+        }
+    }
+    sort(ranked.begin(), ranked.end());
+    ranked.resize(min<int>(ranked.size(), 4 * beamWidth));
+    vector<EvaluationBase> bases(ranked.size());
+    for(int c(0); c != ranked.size(); ++c){
+        evaluationBase(orderCandidates[ranked[c].second], bases[c]);
+    }
+
+    vector<BeamState> beam(1);
+    beam[0].value = 0;
+    BeamState best = beam[0];
+    vector<BeamState> next;
+    //the best sets of all sizes, for the search among the candidates
+    vector<BeamState> bestSets;
+    for(int depth(0); depth != maxActions && !beam.empty(); ++depth){
+        next.clear();
+        for(vector<BeamState>::const_iterator sit = beam.begin(); sit != beam.end() && elapsed() <= maxTime*0.7; ++sit){
+            const BeamState& state = *sit;
+            //the actions of the set are applied to the game while it is extended, and taken back afterwards
+            uint applied = game->appliedOrdersCount();
+            for(vector<int>::const_iterator ait = state.actions.begin(); ait != state.actions.end(); ++ait){
+                const Orders& os = orderCandidates[ranked[*ait].second];
+                for(Orders::const_iterator oit = os.begin(); oit != os.end(); ++oit){
+                    game->applyOrder(*oit);
+                }
+            }
+            //the actions of a set are in the order of the ranking, so every set is built only once
+            int first = state.actions.empty() ? 0 : state.actions.back() + 1;
+            for(int c(first); c < ranked.size(); ++c){
+                const Orders& os = orderCandidates[ranked[c].second];
+                bool enoughShips = true;
+                for(Orders::const_iterator oit = os.begin(); oit != os.end(); ++oit){
+                    if(int(oit->shipsCount) > oit->sourcePlanet->shipsCount()){
+                        enoughShips = false;
+                    }
+                }
+                if(!enoughShips)
+                    continue;
+                int added = addedValue(os, bases[c]);
+                if(added <= 0)
+                    continue;
+                next.push_back(state);
+                BeamState& extended = next.back();
+                extended.actions.push_back(c);
+                extended.value += added;
+            }
+            game->undoOrders(applied);
+        }
+        int width = elapsed() < maxTime*0.35 ? beamWidth : 1;
+        stable_sort(next.begin(), next.end(), betterBeamState);
+        if(next.size() > width){
+            next.resize(width);
+        }
+        if(!next.empty() && next[0].value > best.value){
+            best = next[0];
+        }
+        if(searchCandidates()){
+            bestSets.insert(bestSets.end(), next.begin(), next.end());
+        }
+        beam.swap(next);
+        if(elapsed() > maxTime*0.7)
+            break;
+    }
+
+    if(searchCandidates() && bestSets.size() > 1){
+        stable_sort(bestSets.begin(), bestSets.end(), betterBeamState);
+        bestSets.resize(min<int>(bestSets.size(), rolloutCandidates));
+        vector<Orders> sets(bestSets.size());
+        for(int i(0); i != bestSets.size(); ++i){
+            for(vector<int>::const_iterator ait = bestSets[i].actions.begin(); ait != bestSets[i].actions.end(); ++ait){
+                const Orders& os = orderCandidates[ranked[*ait].second];
+                sets[i].insert(sets[i].end(), os.begin(), os.end());
+            }
+        }
+        int b = bestCandidate(sets);
+        if(b >= 0){
+            best = bestSets[b];
+        }
+    }
+
+    for(vector<int>::const_iterator ait = best.actions.begin(); ait != best.actions.end(); ++ait){
+        const Orders& os = orderCandidates[ranked[*ait].second];
+        if(logging){
+            cerr << "executing action of the best set (value " << best.value << "):" << endl;
+            logOrders(os);
+        }
+        issueOrders(optimizeOrders(os));
+        updatePredictions();
+    }
+    if(logging){
+        cerr << "finished chooseActions, " << best.actions.size() << " actions" << endl;
+    }
+    return !best.actions.empty();
+}
+
+//The score at the end of the game is the difference of all ships. Ships only move between planets, so what changes it are
+//the growth of the planets and the ships lost against neutral planets. For every planet this net gain up to the end of
+//the game follows from its timeline. It adds up over the planets, so a set of orders only has to be simulated at the
+//planets it touches. The enemy may attack any one planet with everything it can send, and the orders are chosen for the
+//best result after the worst of these attacks, then the best result without an attack.
+//Every source of mine can send nothing or one of its best orders, and all combinations of these are tried.
+//The search has to finish in half of the time the heuristics may use, so they still have time if it doesn't.
+//Returns false if the search didn't finish in time, then the heuristics decide as usual.
+bool MyBot::endgame(){
+    if(logging){
+        cerr << "endgame search started..." << endl;
+    }
+    updatePredictions();
+    EndgameSearch search;
+    //the engine runs one more step after the orders of this turn
+    search.turns = turnsRemaining + 1;
+    int n = planets.size();
+    search.baseNets.resize(n);
+    search.attacks.resize(n);
+    search.attackLosses.resize(n);
+    vector<pair<int, int> > losses;
+    static const FleetEvents noEvents;
+    for(int p(0); p != n; ++p){
+        search.baseNets[p] = endgameNet(p, search.turns, noEvents);
+        worstCaseFleets(planets[p], search.attacks[p]);
+        search.attackLosses[p] = endgameNet(p, search.turns, search.attacks[p]) - search.baseNets[p];
+        losses.push_back(make_pair(search.attackLosses[p], p));
+    }
+    sort(losses.begin(), losses.end());
+    for(vector<pair<int, int> >::const_iterator lit = losses.begin(); lit != losses.end(); ++lit){
+        search.attackOrder.push_back(lit->second);
+    }
+
+    //the orders of each source, best first by themselves: all ships, or just enough to take the destination
+    vector<pair<int, Planet*> > sources;
+    for(Planets::const_iterator sit = myPlanets.begin(); sit != myPlanets.end(); ++sit){
+        if((*sit)->shipsCount() > 0){
+            sources.push_back(make_pair(-(*sit)->shipsCount(), *sit));
+        }
+    }
+    sort(sources.begin(), sources.end());
+    long combinations = 1;
+    for(vector<pair<int, Planet*> >::const_iterator sit = sources.begin(); sit != sources.end(); ++sit){
+        Planet* source = sit->second;
+        vector<pair<pair<int, int>, int> > ranked;
+        Orders candidates;
+        for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit){
+            Planet* destination = *pit;
+            int t = source->distance(destination);
+            if(destination == source || t > search.turns)
+                continue;
+            vector<int> amounts(1, source->shipsCount());
+            const Timeline& preds = predictions[destination->planetID()];
+            if(!preds.isMine(t) && preds.shipsCount(t) < source->shipsCount()){
+                amounts.push_back(preds.shipsCount(t) + 1);
+            }
+            for(vector<int>::const_iterator ait = amounts.begin(); ait != amounts.end(); ++ait){
+                Orders os(1, Order(source, destination, *ait));
+                int worst;
+                int val = endgameValue(os, search, worst);
+                ranked.push_back(make_pair(make_pair(-worst, -val), candidates.size()));
+                candidates.push_back(os[0]);
+            }
+        }
+        if(elapsed() > maxTime*0.35){
+            return false;
+        }
+        stable_sort(ranked.begin(), ranked.end());
+        ranked.resize(min<int>(ranked.size(), endgameTargets));
+        if(ranked.empty() || combinations * (ranked.size() + 1) > endgameMaxCombinations)
+            break;
+        combinations *= ranked.size() + 1;
+        search.sources.push_back(source);
+        search.options.push_back(Orders());
+        for(vector<pair<pair<int, int>, int> >::const_iterator rit = ranked.begin(); rit != ranked.end(); ++rit){
+            search.options.back().push_back(candidates[rit->second]);
+        }
+    }
+
+    search.bestValue = endgameValue(search.orders, search, search.bestWorst);
+    search.combinations = 0;
+    if(!endgameSearch(search, 0)){
+        if(logging){
+            cerr << "endgame search ran out of time after " << search.combinations << " combinations" << endl;
+        }
+        return false;
+    }
+    if(logging){
+        cerr << "endgame search finished, " << search.combinations << " combinations of " << search.sources.size()
+             << " sources, value " << search.bestValue << ", worst case " << search.bestWorst << endl;
+    }
+    for(Orders::const_iterator oit = search.best.begin(); oit != search.best.end(); ++oit){
+        issueOrder(*oit, "endgame");
+    }
+    return true;
+}
+
+//tries all options of the sources from the given one on, on top of search.orders. Returns false if the time ran out.
+bool MyBot::endgameSearch(EndgameSearch& search, int source){
+    if(source == search.sources.size()){
+        if(++search.combinations % 64 == 0 && elapsed() > maxTime*0.35){
+            return false;
+        }
+        int worst;
+        int val = endgameValue(search.orders, search, worst);
+        if(worst > search.bestWorst || (worst == search.bestWorst && val > search.bestValue)){
+            search.best = search.orders;
+            search.bestWorst = worst;
+            search.bestValue = val;
+        }
+        return true;
+    }
+    //sending nothing comes first, so on a tie fewer orders are kept
+    if(!endgameSearch(search, source + 1)){
+        return false;
+    }
+    const Orders& options = search.options[source];
+    for(Orders::const_iterator oit = options.begin(); oit != options.end(); ++oit){
+        search.orders.push_back(*oit);
+        bool finished = endgameSearch(search, source + 1);
+        search.orders.pop_back();
+        if(!finished){
+            return false;
+        }
+    }
+    return true;
+}
+
+//the change of the score at the end of the game by the orders, without an attack of the enemy and, in worst, after its worst attack
+int MyBot::endgameValue(const Orders& os, const EndgameSearch& search, int& worst){
+    vector<int> affected;
+    for(Orders::const_iterator oit = os.begin(); oit != os.end(); ++oit){
+        affected.push_back(oit->sourcePlanet->planetID());
+        affected.push_back(oit->destinationPlanet->planetID());
+    }
+    sort(affected.begin(), affected.end());
+    affected.erase(unique(affected.begin(), affected.end()), affected.end());
+
+    int val(0);
+    int attackLoss(0);
+    for(vector<int>::const_iterator pit = affected.begin(); pit != affected.end(); ++pit){
+        ordersToEvents(os, planets[*pit], endgameEvents);
+        int net = endgameNet(*pit, search.turns, endgameEvents);
+        val += net - search.baseNets[*pit];
+        const FleetEvents& attack = search.attacks[*pit];
+        endgameEvents.insert(endgameEvents.end(), attack.begin(), attack.end());
+        attackLoss = min(attackLoss, endgameNet(*pit, search.turns, endgameEvents) - net);
+    }
+    //the worst attack on a planet the orders don't touch is the same as without orders
+    for(vector<int>::const_iterator pit = search.attackOrder.begin(); pit != search.attackOrder.end(); ++pit){
+        if(!binary_search(affected.begin(), affected.end(), *pit)){
+            attackLoss = min(attackLoss, search.attackLosses[*pit]);
+            break;
+        }
+    }
+    worst = val + attackLoss;
+    return val;
+}
+
+//how many ships I gain at the planet until the given turn, minus what the enemy gains there,
+//not counting the ships that arrive at it or leave it
+int MyBot::endgameNet(int planet, int turns, const FleetEvents& events){
+    const Snapshot& snapshot = game->snapshot();
+    snapshot.simulate(planet, turns, events, endgamePredictions);
+    int net(0);
+    int signEnd = endgamePredictions.isMine(turns) ? 1 : (endgamePredictions.isEnemy(turns) ? -1 : 0);
+    int signStart = endgamePredictions.isMine(0) ? 1 : (endgamePredictions.isEnemy(0) ? -1 : 0);
+    net += signEnd * endgamePredictions.shipsCount(turns) - signStart * endgamePredictions.shipsCount(0);
+    for(int f(snapshot.arrivalsBegin[planet]); f != snapshot.arrivalsBegin[planet + 1]; ++f){
+        if(snapshot.fleetArrival[f] <= turns){
+            net -= (snapshot.fleetOwner[f] == MyID ? 1 : -1) * snapshot.fleetShips[f];
+        }
+    }
+    for(FleetEvents::const_iterator e = events.begin(); e != events.end(); ++e){
+        if(e->turn > 0 && e->turn <= turns){
+            net -= (e->owner == MyID ? 1 : -1) * e->shipsCount;
+        }
+    }
+    return net;
+}
+
+bool MyBot::searchCandidates() const{
+    return rollouts || matrixGameMode != NoMatrixGame;
+}
+
+int MyBot::bestCandidate(const vector<Orders>& candidates){
+    if(matrixGameMode != NoMatrixGame){
+        return bestByMatrixGame(candidates);
+    }
+    if(rollouts){
+        return bestByRollouts(candidates);
+    }
+    return -1;
+}
+
+//The enemy's likely responses to the candidates, as seen from his side: doing nothing, sending all ships he can spare
+//to the destinations of my orders to defend or snipe them, or to the sources of my orders to attack them while they are weak.
+//Only his planets within half the map of the target take part.
+void MyBot::enemyResponses(const vector<Orders>& candidates, vector<RolloutEvaluator::Moves>& responses) const{
+    responses.assign(1, RolloutEvaluator::Moves());
+    Planets targets;
+    for(vector<Orders>::const_iterator cit = candidates.begin(); cit != candidates.end(); ++cit){
+        for(Orders::const_iterator oit = cit->begin(); oit != cit->end(); ++oit){
+            if(find(targets.begin(), targets.end(), oit->destinationPlanet) == targets.end()){
+                targets.push_back(oit->destinationPlanet);
+            }
+        }
+    }
+    for(vector<Orders>::const_iterator cit = candidates.begin(); cit != candidates.end(); ++cit){
+        for(Orders::const_iterator oit = cit->begin(); oit != cit->end(); ++oit){
+            if(find(targets.begin(), targets.end(), oit->sourcePlanet) == targets.end()){
+                targets.push_back(oit->sourcePlanet);
+            }
+        }
+    }
+    for(Planets::const_iterator tit = targets.begin(); tit != targets.end() && responses.size() < matrixGameResponses; ++tit){
+        Planet* target = *tit;
+        RolloutEvaluator::Moves moves;
+        for(Planets::const_iterator pit = enemyPlanets.begin(); pit != enemyPlanets.end(); ++pit){
+            Planet* p = *pit;
+            if(p == target || p->distance(target) > maxDistanceBetweenPlanets / 2)
+                continue;
+            //the ships the enemy can send without losing the planet according to the predictions
+            const Timeline& preds = predictions[p->planetID()];
+            int available = p->shipsCount();
+            for(int t(0); t != preds.size(); ++t){
+                available = min(available, preds.isEnemy(t) ? preds.shipsCount(t) : 0);
+            }
+            if(available > 0){
+                GameState::Move move = { int(p->planetID()), int(target->planetID()), available };
+                moves.push_back(move);
+            }
+        }
+        if(!moves.empty()){
+            responses.push_back(moves);
+        }
+    }
+}
+
+//my moves and the enemy's moves in this turn, then no more orders until the end of the lookahead
+int MyBot::payoff(const GameState& state, const RolloutEvaluator::Moves& moves){
+    vector<int> key;
+    for(RolloutEvaluator::Moves::const_iterator m = moves.begin(); m != moves.end(); ++m){
+        key.push_back(m->source);
+        key.push_back(m->destination);
+        key.push_back(m->shipsCount);
+    }
+    map<vector<int>, int>::const_iterator cached = payoffCache.find(key);
+    if(cached != payoffCache.end()){
+        return cached->second;
+    }
+    GameState played = state;
+    played.step(moves.empty() ? 0 : &moves[0], moves.size());
+    for(int t(1); t < lookahead && played.winner() < 0; ++t){
+        played.step(0, 0);
+    }
+    int result = RolloutEvaluator::score(played, lookahead);
+    payoffCache[key] = result;
+    return result;
+}
+
+//Builds the payoff matrix of the candidates against the enemy's responses, one column at a time, so that all candidates
+//are compared against the same responses if the time runs out. The simulations are memoized for the turn.
+//Returns the chosen candidate, or -1 if not even one column was filled.
+int MyBot::bestByMatrixGame(const vector<Orders>& candidates){
+    GameState state;
+    if(candidates.empty() || !state.set(game->snapshot(), game->turn())){
+        return -1;
+    }
+    if(payoffCacheVersion != game->snapshot().stateVersion()){
+        payoffCache.clear();
+        payoffCacheVersion = game->snapshot().stateVersion();
+    }
+    vector<RolloutEvaluator::Moves> mine(candidates.size());
+    for(int i(0); i != candidates.size(); ++i){
+        for(Orders::const_iterator oit = candidates[i].begin(); oit != candidates[i].end(); ++oit){
+            GameState::Move move = { int(oit->sourcePlanet->planetID()), int(oit->destinationPlanet->planetID()), int(oit->shipsCount) };
+            mine[i].push_back(move);
+        }
+    }
+    vector<RolloutEvaluator::Moves> responses;
+    enemyResponses(candidates, responses);
+
+    double deadline = min(maxTime*0.7, elapsed() + maxTime*0.1);
+    matrixGame.reset(mine.size(), responses.size());
+    RolloutEvaluator::Moves joint;
+    for(int c(0); c != responses.size() && elapsed() < deadline; ++c){
+        for(int r(0); r != mine.size(); ++r){
+            joint = mine[r];
+            joint.insert(joint.end(), responses[c].begin(), responses[c].end());
+            matrixGame.set(r, c, payoff(state, joint));
+        }
+    }
+
+    int best = -1;
+    if(matrixGameMode == MixedMatrixGame){
+        //the row is drawn from the mixed strategy
+        vector<double> weights;
+        matrixGame.mixedStrategy(1000, weights);
+        if(!weights.empty()){
+            std::discrete_distribution<int> rows(weights.begin(), weights.end());
+            best = rows(matrixGameRandom);
+        }
+    } else {
+        best = matrixGame.maximinRow();
+    }
+    if(logging){
+        cerr << "matrix game of " << mine.size() << " candidates against " << responses.size() << " responses, chose " << best << endl;
+    }
+    return best;
+}
+
+//Plays out each of the candidates, with my orders of this turn and a simple policy for both players afterwards.
+//The rollouts get a slice of the time that is left. Returns the index of the candidate with the best mean score,
+//or -1 if there was no time for any rollout.
+int MyBot::bestByRollouts(const vector<Orders>& candidates){
+    GameState state;
+    if(candidates.empty() || !state.set(game->snapshot(), game->turn())){
+        return -1;
+    }
+    vector<RolloutEvaluator::Moves> moves(candidates.size());
+    for(int i(0); i != candidates.size(); ++i){
+        for(Orders::const_iterator oit = candidates[i].begin(); oit != candidates[i].end(); ++oit){
+            GameState::Move move = { int(oit->sourcePlanet->planetID()), int(oit->destinationPlanet->planetID()), int(oit->shipsCount) };
+            moves[i].push_back(move);
+        }
+    }
+    double deadline = t1 + min(maxTime*0.7, elapsed() + maxTime*0.1);
+    vector<double> scores;
+    vector<int> counts;
+    rolloutEvaluator.evaluate(state, moves, rolloutsCount, rolloutDepth, deadline, scores, counts);
+    int best = -1;
+    for(int i(0); i != candidates.size(); ++i){
+        if(logging){
+            cerr << "rollouts of candidate " << i << ": " << counts[i] << ", mean score " << scores[i] << endl;
+        }
+        if(counts[i] > 0 && (best < 0 || scores[i] > scores[best])){
+            best = i;
+        }
+    }
+    return best;
+}
+
 void MyBot::logOrders(const Orders& os){
     for(Orders::const_iterator oit = os.begin(); oit != os.end(); ++oit){
         cerr << oit->sourcePlanet->planetID() << " " << oit->destinationPlanet->planetID() << " " << oit->shipsCount << endl;
@@ -424,16 +1079,20 @@ Orders MyBot::optimizeOrders(const Orders& os){
     if(logging){
         cerr << "sa: " << sa1 << ", " << sa2 << endl; 
     }
+    vector<Orders> variants;
     for(int i(0); i <= divs1; ++i){
         for(int j(0); j <= divs2 ; ++j){
-            gettimeofday(&tim, NULL);
-            double t2=tim.tv_sec+(tim.tv_usec/1000000.0);
-            if((t2-t1)>maxTime*0.7)
-                return osMax;
             Orders ovec;
             ovec.push_back(Order(source1, dest, divs1>0 ? (i * sa1) / divs1 : 0));
             ovec.push_back(Order(source2, dest, divs2>0 ? (j * sa1) / divs2 : 0));
-            int val = value(ovec);
+            variants.push_back(ovec);
+        }
+    }
+    vector<int> variantValues;
+    bool finished = values(variants, variantValues);
+    for(int i(0); i <= divs1; ++i){
+        for(int j(0); j <= divs2 ; ++j){
+            int val = variantValues[i * (divs2 + 1) + j];
             if(logging){
                 cerr << i << ", " << j << ": " << val << endl;
             }
@@ -444,6 +1103,9 @@ Orders MyBot::optimizeOrders(const Orders& os){
             } 
         }
     }
+    if(!finished){
+        return osMax;
+    }
     if(maxVal>0){
         return osMax;
     } else {
@@ -470,9 +1132,9 @@ void MyBot::supply() {
         if (p->frontierStatus) {
             shipsAvail[p] = 0;
         } else {
-            shipsAvail[p] = shipsAvailable(predictions[p],lookahead);
+            shipsAvail[p] = shipsAvailable(predictions[p->planetID()],lookahead);
             if(shipsAvail[p] < 0){
-                p->frontierStatus = true;
+                setFrontierStatus(p, true);
                 if(logging){
                     cerr << "Planet " << p->planetID() << " is in peril and has been set as frontier" << endl;
                 }
@@ -483,16 +1145,17 @@ void MyBot::supply() {
 
 
     //send available ships to the frontier
+    updateSupplyRoutes();
     for(Planets::const_iterator pit = myPlanets.begin(); pit != myPlanets.end(); ++pit) {
         Planet* p = *pit;
         if (shipsAvail[p]>0) {
-            Planet* target = game->planetByID(supplyMove(p, nearestFrontierPlanet(p)));
+            Planet* target = game->planetByID(supplyRoutes[p->planetID()]);
             if (target->owner()->isMe() 
                 || target->predictedMine) {
                 Order o(p, target, shipsAvail[p]);
                 issueOrder(o, "supply to own planet");
                 shipsAvail[p] = 0;
-            } else if(competitivePredictions[target][p->distance(target)].owner()->isMe() &&  competitivePredictions[target][lookahead].owner()->isMe()){
+            } else if(competitivePredictions[target->planetID()].isMine(p->distance(target)) &&  competitivePredictions[target->planetID()].isMine(lookahead)){
                 Order o(p, target, shipsAvail[p]);
                 issueOrder(o, "supply, hope to gain");
                 shipsAvail[p] = 0;
@@ -523,7 +1186,7 @@ void MyBot::panic(){
                 Planet* p2 = *pit2;
                 if(p2->owner()->isEnemy()){
                     int dist = p->distance(p2);
-                    int shipsRequired = predictions[p2][dist].shipsCount() + 1;
+                    int shipsRequired = predictions[p2->planetID()].shipsCount(dist) + 1;
                     if(p->shipsCount() >= shipsRequired){
                         Order o(p, p2, shipsRequired);
                         issueOrder(o, "panic");
@@ -543,12 +1206,12 @@ void MyBot::addOrderCandidates(Planet* source1, Planet* source2, vector<Orders>&
     if(logging){
         cerr << "adding order candidates for planets " << source1->planetID() << " and " << source2->planetID() << "..." <<  endl;
     }
-    int shipsAvailableStatic1 = shipsAvailable(predictions[source1],lookahead);
-    if (!source2->frontierStatus && shipsAvailableStatic1 < 0 && willHoldFor(predictions[source1], 0) < source1->distance(nearestFriendlyPlanet(source1))) {
+    int shipsAvailableStatic1 = shipsAvailable(predictions[source1->planetID()],lookahead);
+    if (!source2->frontierStatus && shipsAvailableStatic1 < 0 && willHoldFor(predictions[source1->planetID()], 0) < source1->distance(nearestFriendlyPlanet(source1))) {
         shipsAvailableStatic1 = source1->shipsCount();
     }
-    int shipsAvailableStatic2 = shipsAvailable(predictions[source2],lookahead);
-    if (!source2->frontierStatus && shipsAvailableStatic2 < 0 && willHoldFor(predictions[source2], 0) < source2->distance(nearestFriendlyPlanet(source2))) {
+    int shipsAvailableStatic2 = shipsAvailable(predictions[source2->planetID()],lookahead);
+    if (!source2->frontierStatus && shipsAvailableStatic2 < 0 && willHoldFor(predictions[source2->planetID()], 0) < source2->distance(nearestFriendlyPlanet(source2))) {
         shipsAvailableStatic2 = source2->shipsCount();
     }
     for(Planets::const_iterator p = planets.begin(); p!= planets.end(); ++p) {
@@ -557,31 +1220,31 @@ void MyBot::addOrderCandidates(Planet* source1, Planet* source2, vector<Orders>&
         if((t2-t1)>maxTime*0.7)
             return;
         Planet* destination = *p;
+        const Timeline& destinationPredictions = predictions[destination->planetID()];
         int dist = max(source1->distance(destination), source2->distance(destination));
-        if(destination != source1 && destination != source2 && dist <= turnsRemaining && dist <= maxDistanceBetweenPlanets / 2 && abs(source1->distance(destination)-source2->distance(destination)) < maxDistanceBetweenPlanets / 4 && !(destination->owner()->isMe() && predictions[destination][lookahead].owner()->isMe()) && !(me->growthRate() > enemy->growthRate() && myPredictedGrowth > enemyPredictedGrowth && destination->owner()->isNeutral() && predictions[destination][lookahead].owner()->isNeutral()) && !(destination->owner()->isNeutral() && predictions[destination][dist].owner()->isNeutral() && predictions[destination][dist].shipsCount() >= destination->growthRate()*(turnsRemaining - dist))){
-            int shipsAvailableCompetitive1 = shipsAvailable(competitivePredictions[source1], dist*2);
-            int shipsAvailableCompetitive2 = shipsAvailable(competitivePredictions[source2], dist*2);
+        if(destination != source1 && destination != source2 && dist <= turnsRemaining && dist <= maxDistanceBetweenPlanets / 2 && abs(source1->distance(destination)-source2->distance(destination)) < maxDistanceBetweenPlanets / 4 && !(destination->owner()->isMe() && destinationPredictions.isMine(lookahead)) && !(me->growthRate() > enemy->growthRate() && myPredictedGrowth > enemyPredictedGrowth && destination->owner()->isNeutral() && destinationPredictions.isNeutral(lookahead)) && !(destination->owner()->isNeutral() && destinationPredictions.isNeutral(dist) && destinationPredictions.shipsCount(dist) >= destination->growthRate()*(turnsRemaining - dist))){
+            int shipsAvailableCompetitive1 = shipsAvailable(competitivePredictions[source1->planetID()], dist*2);
+            int shipsAvailableCompetitive2 = shipsAvailable(competitivePredictions[source2->planetID()], dist*2);
             if (max(shipsAvailableStatic1, shipsAvailableCompetitive1)>0 && max(shipsAvailableStatic2, shipsAvailableCompetitive2)>0) {
-                Planet futureDestination = predictions[destination][dist];
-                int shipsRequired = futureDestination.shipsCount()+1;
-                if (futureDestination.owner()->isMe()) {
+                int shipsRequired = destinationPredictions.shipsCount(dist)+1;
+                if (destinationPredictions.isMine(dist)) {
                     for(int t(dist); t!=lookahead+1; ++t) {
-                        if (predictions[destination][t].owner()->isEnemy()) {
-                            shipsRequired = predictions[destination][t].shipsCount()+1;
+                        if (destinationPredictions.isEnemy(t)) {
+                            shipsRequired = destinationPredictions.shipsCount(t)+1;
                             break;
                         }
                     }
                     continue;
                 }
-                int shipsRequiredWorstCase = worstCasePredictions[destination][dist].shipsCount()+1;
+                int shipsRequiredWorstCase = worstCasePredictions[destination->planetID()].shipsCount(dist)+1;
                 //the conditions for validity make sure that my bot is not too aggressive, and does not attack neutrals when the enemy can snipe
                 bool valid =  shipsRequired <= min(shipsAvailableCompetitive1, shipsAvailableStatic1) + min(shipsAvailableCompetitive2, shipsAvailableStatic2) 
-                    &&!(futureDestination.owner()->isNeutral() 
+                    &&!(destinationPredictions.isNeutral(dist) 
                         && me->shipsCount()*2 < enemy->shipsCount() ) 
-                    && !(futureDestination.owner()->isEnemy() 
-                         && predictions[destination][dist-1].owner()->isNeutral()) 
-                    && (competitivePredictions[destination][dist].owner()->isMe() 
-                        || competitivePredictions[destination][min(lookahead, 2*dist)].owner()->isMe()
+                    && !(destinationPredictions.isEnemy(dist) 
+                         && destinationPredictions.isNeutral(dist-1)) 
+                    && (competitivePredictions[destination->planetID()].isMine(dist) 
+                        || competitivePredictions[destination->planetID()].isMine(min(lookahead, 2*dist))
                         || (me->growthRate() < enemy->growthRate() 
                             && myPredictedGrowth < enemyPredictedGrowth)
                         || dist <= maxDistanceBetweenPlanets/6);
@@ -640,13 +1303,20 @@ void MyBot::addOrderCandidates(Planet* source1, Planet* source2, vector<Orders>&
 }
 
 
-list<Fleet> MyBot::ordersToFleets(const Orders& os){
-    list<Fleet> fs;
+//the ships leaving and arriving at planet pl if the orders were issued
+void MyBot::ordersToEvents(const Orders& os, Planet* pl, FleetEvents& events) const{
+    const Snapshot& snapshot = game->snapshot();
+    events.clear();
     for(Orders::const_iterator oit = os.begin(); oit != os.end(); ++oit){
-        int dist = oit->sourcePlanet->distance(oit->destinationPlanet);
-        fs.push_back(Fleet(oit->sourcePlanet->owner(), oit->sourcePlanet, oit->destinationPlanet, oit->shipsCount, dist, dist));
+        if(oit->sourcePlanet == pl){
+            FleetEvent departure = { 0, snapshot.planetOwner[pl->planetID()], int(oit->shipsCount) };
+            events.push_back(departure);
+        }
+        if(oit->destinationPlanet == pl){
+            FleetEvent arrival = { int(oit->sourcePlanet->distance(pl)), snapshot.planetOwner[oit->sourcePlanet->planetID()], int(oit->shipsCount) };
+            events.push_back(arrival);
+        }
     }
-    return fs;
 }
 
 int MyBot::value(const Orders& os, bool worstcase){
@@ -654,29 +1324,77 @@ int MyBot::value(const Orders& os, bool worstcase){
     double t2=tim.tv_sec+(tim.tv_usec/1000000.0);
     if((t2-t1)>maxTime*0.7)
         return 0;
-    set<Planet*> sources;
+    EvaluationBase base;
+    if(!evaluationBase(os, base)){
+        return 0;
+    }
+    return value(os, base);
+}
+
+//evaluates all candidates, candidates with the same destination and sources share the work that doesn't depend on the ships counts.
+//Returns false if it ran out of time, the values of the candidates that were not evaluated are 0.
+bool MyBot::values(const vector<Orders>& candidates, vector<int>& vals){
+    vals.assign(candidates.size(), 0);
+    map<vector<int>, vector<int> > groups;
+    for(int i(0); i != candidates.size(); ++i){
+        const Orders& os = candidates[i];
+        vector<int> key;
+        key.push_back(os[0].destinationPlanet->planetID());
+        for(Orders::const_iterator oit = os.begin(); oit != os.end(); ++oit){
+            key.push_back(oit->sourcePlanet->planetID());
+        }
+        sort(key.begin() + 1, key.end());
+        key.erase(unique(key.begin() + 1, key.end()), key.end());
+        groups[key].push_back(i);
+    }
+    for(map<vector<int>, vector<int> >::const_iterator git = groups.begin(); git != groups.end(); ++git){
+        gettimeofday(&tim, NULL);
+        double t2=tim.tv_sec+(tim.tv_usec/1000000.0);
+        if((t2-t1)>maxTime*0.7)
+            return false;
+        const vector<int>& group = git->second;
+        EvaluationBase base;
+        if(!evaluationBase(candidates[group[0]], base)){
+            continue;
+        }
+        for(vector<int>::const_iterator i = group.begin(); i != group.end(); ++i){
+            vals[*i] = value(candidates[*i], base);
+        }
+    }
+    return true;
+}
+
+//computes the part of the evaluation that only depends on the sources and the destination of the orders.
+//Returns false if the destination is a neutral planet that would not pay off.
+bool MyBot::evaluationBase(const Orders& os, EvaluationBase& base){
+    set<Planet*>& sources = base.sources;
+    sources.clear();
     for(Orders::const_iterator oit = os.begin(); oit != os.end(); ++oit){
         sources.insert(oit->sourcePlanet);
     }
     Planet* destination = os[0].destinationPlanet;  //I assume that all sources have the same destination
-    list<Fleet> fs(ordersToFleets(os));
+    base.destination = destination;
+    const Snapshot& snapshot = game->snapshot();
     int baseValue(0);
     int dist(0);
 
     for(set<Planet*>::const_iterator pit = sources.begin(); pit != sources.end(); ++pit){
         Planet* p = *pit;
         dist = max(dist, destination->distance(p));
-        baseValue += value(predictions[p]);
+        baseValue += value(predictions[p->planetID()]);
     }
 
-    baseValue += value(predictions[destination]);
+    baseValue += value(predictions[destination->planetID()]);
+    base.dist = dist;
+    base.baseValue = baseValue;
 
    
-    if (predictions[destination][dist].owner()->isNeutral()) {  //some tougher payoff conditions for neutral planets
-        list<Fleet> wfsDest = worstCaseFleets(destination);
-        for(list<Fleet>::iterator fit = wfsDest.begin(); fit != wfsDest.end(); ++fit){
-            fit->turnsRemaining_m = max(dist+1, int(fit->turnsRemaining_m));
-            if(fit->turnsRemaining_m > maxDistanceBetweenPlanets / 2){
+    if (predictions[destination->planetID()].isNeutral(dist)) {  //some tougher payoff conditions for neutral planets
+        FleetEvents wfsDest;
+        worstCaseFleets(destination, wfsDest);
+        for(FleetEvents::iterator fit = wfsDest.begin(); fit != wfsDest.end(); ++fit){
+            fit->turn = max(dist+1, fit->turn);
+            if(fit->turn > maxDistanceBetweenPlanets / 2){
                 fit = wfsDest.erase(fit);
                 if(fit == wfsDest.end())
                     break;
@@ -684,39 +1402,66 @@ int MyBot::value(const Orders& os, bool worstcase){
         } 
         for(set<Planet*>::const_iterator pit = sources.begin(); pit != sources.end(); ++pit){
             Planet* p = *pit;
-            uint dist2(p->distance(destination));
-            uint i(0);
-            for(list<Fleet>::const_iterator fit = maxOutgoingFleets[p].begin(); fit != maxOutgoingFleets[p].end(); ++fit){
-                if(fit->owner()->isMe() && fit != maxOutgoingFleets[p].begin()){
-                    Fleet f(Fleet(fit->owner(), p, destination, fit->shipsCount(), dist2 + i, dist2 + i));
+            int dist2(p->distance(destination));
+            const Timeline& maxOutgoing = maxOutgoingFleets[p->planetID()];
+            for(int i(1); i < maxOutgoing.size(); ++i){
+                if(maxOutgoing.isMine(i)){
+                    FleetEvent f = { dist2 + i, maxOutgoing.owner(i), maxOutgoing.shipsCount(i) };
                     wfsDest.push_back(f);
                 }
-                ++i;
             }
         }
 
         //a neutral planet has to pay off even in the close-to worst case:
-        vector<Planet> preds = destination->getPredictions(lookahead,wfsDest);
+        Timeline preds;
+        snapshot.simulate(destination->planetID(), lookahead, wfsDest, preds);
         int whf = willHoldFor(preds, dist)*destination->growthRate();
         if ( whf  < destination->shipsCount()) {
             if(logging){
                 cerr << ">>" << destination->planetID() << " does not fulfill payout conditions for neutrals: " << whf << "<" << destination->shipsCount() << endl;
             }
-            return 0;
+            return false;
         } 
     }
-    vector<Planet> destinationPredictions = destination->getPredictions(lookahead, fs);
-    int newValue = value(destinationPredictions) - baseValue;
-    for(set<Planet*>::const_iterator pit = sources.begin(); pit != sources.end(); ++pit){
+    return true;
+}
+
+int MyBot::value(const Orders& os, const EvaluationBase& base){
+    const Snapshot& snapshot = game->snapshot();
+    Planet* destination = base.destination;
+    ordersToEvents(os, destination, evaluationEvents);
+    snapshot.simulate(destination->planetID(), lookahead, evaluationEvents, evaluationPredictions);
+    int newValue = value(evaluationPredictions) - base.baseValue;
+    for(set<Planet*>::const_iterator pit = base.sources.begin(); pit != base.sources.end(); ++pit){
         Planet* p = *pit;
-        newValue += value(p->getPredictions(lookahead,fs));
+        ordersToEvents(os, p, evaluationEvents);
+        snapshot.simulate(p->planetID(), lookahead, evaluationEvents, evaluationPredictions);
+        newValue += value(evaluationPredictions);
     }
     //higher distance means that the payoff predictions are less reliable, so closer targets are preferable:
-    newValue *= (maxDistanceBetweenPlanets - dist + 1);  
+    newValue *= (maxDistanceBetweenPlanets - base.dist + 1);  
     return newValue;
 }
 
-  
+
+//like value(os, base), but compared to the current state of the game instead of the predictions of the turn,
+//so it also counts the orders applied to the game, e.g. the actions already chosen in a beam search
+int MyBot::addedValue(const Orders& os, const EvaluationBase& base){
+    const Snapshot& snapshot = game->snapshot();
+    int newValue(0);
+    vector<Planet*> affected(base.sources.begin(), base.sources.end());
+    affected.push_back(base.destination);
+    for(vector<Planet*>::const_iterator pit = affected.begin(); pit != affected.end(); ++pit){
+        Planet* p = *pit;
+        snapshot.simulate(p->planetID(), lookahead, evaluationPredictions);
+        newValue -= value(evaluationPredictions);
+        ordersToEvents(os, p, evaluationEvents);
+        snapshot.simulate(p->planetID(), lookahead, evaluationEvents, evaluationPredictions);
+        newValue += value(evaluationPredictions);
+    }
+    newValue *= (maxDistanceBetweenPlanets - base.dist + 1);
+    return newValue;
+}
 
 //find neutral planets that are interesting targets for expansion, and enemy planets that I might be able to conquer
 //TODO: similar for enemy planets
@@ -729,15 +1474,15 @@ void MyBot::setExpansionTargets(){
         Planets temp = myPlanets;
         temp.push_back(p);
         if (p->growthRate()>0 
-            && (predictions[p][lookahead].owner()->isNeutral() 
-                && competitivePredictions[p][lookahead].owner()->isMe() 
+            && (predictions[p->planetID()].isNeutral(lookahead) 
+                && competitivePredictions[p->planetID()].isMine(lookahead) 
                 && (me->shipsCount() 
                     + me->growthRate() * distance(enemyPlanets,temp) 
-                    - predictions[p][lookahead].shipsCount() 
+                    - predictions[p->planetID()].shipsCount(lookahead) 
                     >= enemy->shipsCount()) 
                 && (me->growthRate() < enemy->growthRate() 
                     || myPredictedGrowth < enemyPredictedGrowth))) {
-            int timeToPayoff = predictions[p][lookahead].shipsCount() / p->growthRate();
+            int timeToPayoff = predictions[p->planetID()].shipsCount(lookahead) / p->growthRate();
             if (timeToPayoff < fastestPayoff) {
                 fastestPayoff = timeToPayoff;
                 fastestPayoffPlanet = p;
@@ -745,17 +1490,17 @@ void MyBot::setExpansionTargets(){
         }
     }
     if (fastestPayoff < maxDistanceBetweenPlanets && fastestPayoffPlanet) {
-        fastestPayoffPlanet->frontierStatus = true;
+        setFrontierStatus(fastestPayoffPlanet, true);
         if(logging){
             cerr << "Set expansion target: " << fastestPayoffPlanet->planetID() << endl;
         }
         for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
             Planet* p = *pit;
             if (p != fastestPayoffPlanet &&  protects(fastestPayoffPlanet, p)) {
-                p->frontierStatus = false;
+                setFrontierStatus(p, false);
                 int dist = p->distance(fastestPayoffPlanet);
-                if(competitivePredictions[fastestPayoffPlanet][dist].owner()->isMe()){
-                    int sa = min(shipsAvailable(predictions[p], dist), shipsAvailable(competitivePredictions[p], dist));
+                if(competitivePredictions[fastestPayoffPlanet->planetID()].isMine(dist)){
+                    int sa = min(shipsAvailable(predictions[p->planetID()], dist), shipsAvailable(competitivePredictions[p->planetID()], dist));
                     issueOrder(Order(p, fastestPayoffPlanet, sa), "quick supply");
                 }
             }
@@ -765,14 +1510,14 @@ void MyBot::setExpansionTargets(){
 
     for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
         Planet* p = *pit;
-        if ((p->owner()->isEnemy() || predictions[p][lookahead].owner()->isEnemy()) && competitivePredictions[p][lookahead].owner()->isMe()) {
-            p->frontierStatus = true;
+        if ((p->owner()->isEnemy() || predictions[p->planetID()].isEnemy(lookahead)) && competitivePredictions[p->planetID()].isMine(lookahead)) {
+            setFrontierStatus(p, true);
             for(Planets::const_iterator pit2 = planets.begin(); pit2 != planets.end(); ++pit2) {
                 Planet* p2 = *pit;
                 if (p2->planetID() != p->planetID() &&  protects(p, p2) && p2->owner()->isMe()) {
                     int dist = p->distance(fastestPayoffPlanet);
-                    p->frontierStatus = false;
-                    int sa = min(shipsAvailable(predictions[p], dist), shipsAvailable(competitivePredictions[p], dist));
+                    setFrontierStatus(p, false);
+                    int sa = min(shipsAvailable(predictions[p->planetID()], dist), shipsAvailable(competitivePredictions[p->planetID()], dist));
                     issueOrder(Order(p, fastestPayoffPlanet, sa), "quick supply");
                 }
             }
@@ -783,206 +1528,315 @@ void MyBot::setExpansionTargets(){
 }
 
 //evaluates a list of predictions for a planet. This is used to calculate the value of an action/order.
-int MyBot::value(const vector<Planet>& preds) const{
+int MyBot::value(const Timeline& preds) const{
     int factor = 0;
-    Planet finalPlanet = preds[min(lookahead,turnsRemaining)];
-    if (finalPlanet.owner()->isMe()) {
+    int t = min(lookahead,turnsRemaining);
+    if (preds.isMine(t)) {
         factor = 1;
-    } else if (finalPlanet.owner()->isEnemy()) {
+    } else if (preds.isEnemy(t)) {
         factor = -1;
     }
-    return finalPlanet.shipsCount() * factor;
+    return preds.shipsCount(t) * factor;
 }
+  
 
-list<Fleet> MyBot::computeMaxOutgoingFleets(Planet* pl){
-    list<Fleet> outFleets;
-    Planet p = *pl;
-    if(!p.owner()->isNeutral()){
-        Fleet f(p.owner(), p.shipsCount());
-        outFleets.push_back(f);
-        p.shipsCount_m = 0;
-    } else {
-        outFleets.push_back(Fleet(p.owner(), 0));
+
+//the following functions define the "protects" relationship and some utility function. 
+//Planet A protects planet B from planet C, iff B can safely send ships to A, and A is closer to B than C. 
+//This only depends on the distances, so it is computed once per map:
+//protectors[B*n+C] are the planets that protect B from C,
+//threats[A*n+B] are the planets closer than 2*dist(A,B) to B that A does not protect B from.
+//The dynamic questions are then set operations with the planets of each owner.
+void MyBot::computeProtection() {
+    const Snapshot& snapshot = game->snapshot();
+    const Planets& planets = game->planets();
+    int n = snapshot.planetsCount();
+    MapCache& cache = game->mapCache();
+    vector<unsigned long long> words;
+    if (cache.get(MapCache::ClosenessRanks, closenessRanks) && closenessRanks.size() == n * n
+        && cache.get(MapCache::Protectors, words) && PlanetSet::fromWords(words, n, n * n, protectors)
+        && cache.get(MapCache::Threats, words) && PlanetSet::fromWords(words, n, n * n, threats)) {
+        return;
     }
-    for(int i(0); i != lookahead+1; ++i){
-        p = p.getPredictions(1,i)[1];
-        if(!p.owner()->isNeutral()){
-            outFleets.push_back(Fleet(p.owner(), p.shipsCount()));
-            p.shipsCount_m = 0;
-        } else {
-            outFleets.push_back(Fleet(p.owner(), 0));
+    protectors.assign(n * n, PlanetSet(n));
+    threats.assign(n * n, PlanetSet(n));
+    closenessRanks.assign(n * n, 0);
+    //on a symmetric map only the rows of one half are computed, the other half is their mirror image
+    const vector<int>& mirrors = game->mirrors();
+    for(int b(0); b != n; ++b) {
+        if (mirrors[b] < b) {
+            continue;
+        }
+        for(int c(0); c != n; ++c) {
+            for(int a(0); a != n; ++a) {
+                if (snapshot.distance(c, a) < snapshot.distance(c, b) && 2 * snapshot.distance(b, a) <= snapshot.distance(c, b)) {
+                    protectors[b * n + c].insert(a);
+                }
+            }
+        }
+    }
+    for(int b(0); b != n; ++b) {
+        if (mirrors[b] < b) {
+            for(int c(0); c != n; ++c) {
+                protectors[b * n + c] = protectors[mirrors[b] * n + mirrors[c]].mapped(mirrors);
+            }
+        }
+    }
+    for(int a(0); a != n; ++a) {
+        if (mirrors[a] < a) {
+            continue;
+        }
+        for(int b(0); b != n; ++b) {
+            for(int c(0); c != n; ++c) {
+                if (c != b && snapshot.distance(c, b) < 2 * snapshot.distance(a, b) && !protectors[b * n + c].contains(a)) {
+                    threats[a * n + b].insert(c);
+                }
+            }
+        }
+    }
+    for(int a(0); a != n; ++a) {
+        if (mirrors[a] < a) {
+            for(int b(0); b != n; ++b) {
+                threats[a * n + b] = threats[mirrors[a] * n + mirrors[b]].mapped(mirrors);
+            }
+        }
+    }
+    for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
+        Planet* pl = *pit;
+        const Planets& closest = pl->closestPlanets();
+        for(int i(0); i != closest.size(); ++i) {
+            closenessRanks[pl->planetID() * n + closest[i]->planetID()] = i + 1;
         }
     }
-    return outFleets;
+    cache.put(MapCache::ClosenessRanks, closenessRanks);
+    PlanetSet::toWords(protectors, words);
+    cache.put(MapCache::Protectors, words);
+    PlanetSet::toWords(threats, words);
+    cache.put(MapCache::Threats, words);
 }
-  
 
+//the planets of each player, and the planets of all other players except neutral
+void MyBot::updateOwnerMasks() {
+    const Snapshot& snapshot = game->snapshot();
+    int n = snapshot.planetsCount();
+    ownerMasks.assign(snapshot.playersCount(), PlanetSet(n));
+    hostileMasks.assign(snapshot.playersCount(), PlanetSet(n));
+    PlanetSet nonNeutral(n);
+    for(int i(0); i != n; ++i) {
+        ownerMasks[snapshot.planetOwner[i]].insert(i);
+        if (snapshot.planetOwner[i] != NeutralID) {
+            nonNeutral.insert(i);
+        }
+    }
+    for(int k(0); k != snapshot.playersCount(); ++k) {
+        hostileMasks[k] = nonNeutral;
+        hostileMasks[k] -= ownerMasks[k];
+    }
+}
 
-//the following functions define the "protects" relationship and some utility function. 
-//Planet A protects planet B from planet C, iff B can safely send ships to A, and A is closer to B than C. 
 bool MyBot::protects(Planet* protector, Planet* protectee, Planet* from) const{
-    return (from->distance(protector) < from->distance(protectee) 
-            && 2*protectee->distance(protector) <= from->distance(protectee));
+    return protectors[protectee->planetID() * planets.size() + from->planetID()].contains(protector->planetID());
 }
 
 
 //Planet A protects planet B, if A protects B from all enemy planets.
 bool MyBot::protects(Planet* protector, Planet* protectee) const{
-    Planets closest = protectee->closestPlanets();
-    int dist = protector->distance(protectee);
-    for(Planets::const_iterator pit = closest.begin(); pit != closest.end(); ++pit) {
-        Planet* p = *pit;
-        if (p->distance(protectee) >= 2 * dist) {
-            return true;
-        }
-        if (p->owner() != protectee->owner() 
-            && !p->owner()->isNeutral() 
-            && !protects(protector, protectee, p)) {
-            return false;
-        }
-    }
-    return true;
+    const PlanetSet& hostile = hostileMasks[game->snapshot().planetOwner[protectee->planetID()]];
+    return !threats[protector->planetID() * planets.size() + protectee->planetID()].intersects(hostile);
 }
 
 //returns true iff there is a planet that has the same owner as pl, and protects pl from Planet 'from'.
 bool MyBot::isProtectedFrom(Planet* pl, Planet* from) const{
-    Planets closest = pl->closestPlanets();
-    int dist = from->distance(pl);
-    for(Planets::const_iterator pit = closest.begin(); pit != closest.end(); ++pit) {
-        Planet* p = *pit;
-        if (p->owner() == pl->owner() && protects(p, pl, from)) {
-            return true;
-        }
-        if (p->distance(pl) > dist) {
-            return false;
-        }
-    }
-    return false;
+    const PlanetSet& friends = ownerMasks[game->snapshot().planetOwner[pl->planetID()]];
+    return protectors[pl->planetID() * planets.size() + from->planetID()].intersects(friends);
 }
 
+//returns the closest planet that has the same owner as pl and protects pl from Planet 'from', or pl if there is none.
 Planet* MyBot::isProtectedFromBy(Planet* pl, Planet* from) const{
-    Planets closest = pl->closestPlanets();
-    int dist = from->distance(pl);
-    for(Planets::const_iterator pit = closest.begin(); pit != closest.end(); ++pit) {
-        Planet* p = *pit;
-        if (p->owner() == pl->owner() && protects(p, pl, from)) {
-            return p;
-        }
-        if (p->distance(pl) > dist) {
-            return pl;
+    int n = planets.size();
+    const PlanetSet& friends = ownerMasks[game->snapshot().planetOwner[pl->planetID()]];
+    const PlanetSet& ps = protectors[pl->planetID() * n + from->planetID()];
+    int closestProtector(-1);
+    for(int p = ps.next(0); p >= 0; p = ps.next(p + 1)) {
+        if (friends.contains(p) && (closestProtector < 0 || closenessRanks[pl->planetID() * n + p] < closenessRanks[pl->planetID() * n + closestProtector])) {
+            closestProtector = p;
         }
     }
-    return pl;
+    return closestProtector < 0 ? pl : planets[closestProtector];
 }
 
 
 //returns true iff planet pl is protected from all enemy planets
 bool MyBot::isProtected(Planet* pl) const{
-    Planets closest = pl->closestPlanets();
-    for(Planets::const_iterator pit = closest.begin(); pit != closest.end(); ++pit) {
+    int n = planets.size();
+    const PlanetSet& hostile = hostileMasks[game->snapshot().planetOwner[pl->planetID()]];
+    for(int p = hostile.next(0); p >= 0; p = hostile.next(p + 1)) {
+        if (!protectors[pl->planetID() * n + p].intersects(ownerMasks[MyID])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//determines my frontier planets.
+//Simplified, pl is a frontier planet, if there is an enemy planet e, such that pl minimizes the distance from my planets to e.
+//Exactly: e is the closest enemy planet to pl, and going through the planets closest to e, pl comes before any of my
+//planets p2 with p2->distance(pl) < pl->distance(e). Every planet has only one e, so this takes O(N^2).
+//The result only depends on owners and predicted owners, so it is only recomputed if one of them changed.
+void MyBot::updateFrontier() {
+    const Snapshot& snapshot = game->snapshot();
+    int n = planets.size();
+    vector<char> flags(n);
+    for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
         Planet* p = *pit;
-        if (p->owner() != pl->owner() && !p->owner()->isNeutral()) {
-            bool protectedFromp(false);
+        flags[p->planetID()] = p->owner()->isMe() | p->owner()->isEnemy() << 1 | p->predictedMine << 2 | p->predictedEnemy << 3;
+    }
+    if (flags != frontierFlags) {
+        frontierFlags = flags;
+        frontier.assign(n, false);
+        for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
+            Planet* pl = *pit;
+            if (!(pl->owner()->isMe() || pl->predictedMine))
+                continue;
+            Planet* e(0);
+            const Planets& closest = pl->closestPlanets();
             for(Planets::const_iterator pit2 = closest.begin(); pit2 != closest.end(); ++pit2) {
-                Planet* p2 = *pit2;
-                if (p2->owner()->isMe() && protects(p2,pl,p)) {
-                    protectedFromp = true;
+                Planet* p = *pit2;
+                if (!p->predictedMine && (p->owner()->isEnemy() || p->predictedEnemy)) {
+                    e = p;
                     break;
                 }
             }
-            if (!protectedFromp) {
-                return false;
+            if (!e)
+                continue;
+            int dist = snapshot.distance(pl->planetID(), e->planetID());
+            const Planets& e_closest = e->closestPlanets();
+            for(Planets::const_iterator pit2 = e_closest.begin(); pit2 != e_closest.end(); ++pit2) {
+                Planet* p2 = *pit2;
+                if (p2 == pl) {
+                    frontier[pl->planetID()] = true;
+                    break;
+                }
+                if ((p2->owner()->isMe() || p2->predictedMine) && snapshot.distance(p2->planetID(), pl->planetID()) < dist) {
+                    break;
+                }
             }
         }
     }
-    return true;
+    for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
+        Planet* p = *pit;
+        if(logging && frontier[p->planetID()]){
+            cerr << "Planet " << p->planetID() << " has been set as Frontier by updateFrontier()" << endl;
+        }
+        setFrontierStatus(p, frontier[p->planetID()]);
+    }
 }
 
 
-//determines if planet pl is one of my frontier planets.
-//Simplified, pl is a frontier planet, if there is an enemy planet e, such that pl minimizes the distance from my planets to e.
-bool MyBot::isFrontier(Planet* pl) const{
-    if (!(pl->owner()->isMe() || pl->predictedMine)) {
-        return false;
+//finds for every planet the closest enemy and friendly planet. Owners only change between turns.
+void MyBot::updateOwnerProximity() {
+    nearestEnemies.resize(planets.size());
+    nearestFriends.resize(planets.size());
+    for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
+        Planet* pl = *pit;
+        Planet* enemyPlanet = pl->owner()->isEnemy() ? pl : 0;
+        Planet* friendlyPlanet = 0;
+        const Planets& closest = pl->closestPlanets();
+        for(Planets::const_iterator pit2 = closest.begin(); pit2 != closest.end() && !(enemyPlanet && friendlyPlanet); ++pit2) {
+            Planet* p = *pit2;
+            if (!enemyPlanet && p->owner()->isEnemy())
+                enemyPlanet = p;
+            if (!friendlyPlanet && p->owner()->isMe())
+                friendlyPlanet = p;
+        }
+        nearestEnemies[pl->planetID()] = enemyPlanet ? enemyPlanet : pl;
+        nearestFriends[pl->planetID()] = friendlyPlanet ? friendlyPlanet : pl;
     }
-    Planets closest = pl->closestPlanets();
-    for(Planets::iterator pit = closest.begin(); pit != closest.end(); ++pit) {
-        Planet* p = *pit;
-        if (!p->predictedMine && (p->owner()->isEnemy() || p->predictedEnemy)) {
-            Planets p_closest = p->closestPlanets();
-            for(Planets::iterator pit2 = p_closest.begin(); pit2 != p_closest.end(); ++pit2) {
-                Planet* p2 = *pit2;
-                if (p2->planetID() == pl->planetID()) {
-                    if(logging){
-                        cerr << "Planet " << pl->planetID() << " has been set as Frontier by isFrontier()" << endl;
-                    }
-                    return true;
+}
+
+//finds for every planet the closest frontier planet, and the closest planet of the same owner that is closer to the frontier.
+void MyBot::updateFrontierProximity() const {
+    nearestFrontiers.resize(planets.size());
+    frontierDistances.resize(planets.size());
+    nextCloserToFrontier.resize(planets.size());
+    for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
+        Planet* pl = *pit;
+        Planet* frontierPlanet = pl;
+        if (!pl->frontierStatus) {
+            const Planets& closest = pl->closestPlanets();
+            for(Planets::const_iterator pit2 = closest.begin(); pit2 != closest.end(); ++pit2) {
+                if ((*pit2)->frontierStatus) {
+                    frontierPlanet = *pit2;
+                    break;
                 }
-                if ((p2->owner()->isMe() || p2->predictedMine)  && p2->distance(pl) < pl->distance(p)) {
-                    return false;
+            }
+        }
+        nearestFrontiers[pl->planetID()] = frontierPlanet;
+        frontierDistances[pl->planetID()] = pl->distance(frontierPlanet);
+    }
+    for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
+        Planet* pl = *pit;
+        Planet* next = pl;
+        if (!pl->frontierStatus) {
+            int dist = frontierDistances[pl->planetID()];
+            const Planets& closest = pl->closestPlanets();
+            for(Planets::const_iterator pit2 = closest.begin(); pit2 != closest.end(); ++pit2) {
+                Planet* p = *pit2;
+                if (p->owner() == pl->owner() && frontierDistances[p->planetID()] < dist) {
+                    next = p;
+                    break;
                 }
             }
         }
+        nextCloserToFrontier[pl->planetID()] = next;
+    }
+    frontierProximityValid = true;
+}
+
+//all changes of the frontier go through here, so the frontier proximity table can be kept up to date
+void MyBot::setFrontierStatus(Planet* pl, bool frontier) {
+    if (pl->frontierStatus != frontier) {
+        pl->frontierStatus = frontier;
+        if (frontier) {
+            frontierPlanets.insert(pl->planetID());
+        } else {
+            frontierPlanets.erase(pl->planetID());
+        }
+        frontierProximityValid = false;
     }
-    return false;
 }
 
 
 //returns my next frontier planet
 Planet* MyBot::nearestFrontierPlanet(Planet* pl) const{
-    if (pl->frontierStatus)
-        return pl;
-    Planets closest = pl->closestPlanets();
-    for(Planets::iterator pit = closest.begin(); pit != closest.end(); ++pit) {
-        Planet* p = *pit;
-        if (p->frontierStatus)
-            return p;
-    }
-    return pl;
+    if (!frontierProximityValid)
+        updateFrontierProximity();
+    return nearestFrontiers[pl->planetID()];
 }
 
 
 Planet* MyBot::nearestEnemyPlanet(Planet* pl) const{
-    if(pl->owner()->isEnemy()){
-        return pl;
-    }
-    Planets closest = pl->closestPlanets();
-    for(Planets::iterator pit = closest.begin(); pit != closest.end(); ++pit) {
-        Planet* p = *pit;
-        if (p->owner()->isEnemy())
-            return p;
-    }
-    return pl;
+    return nearestEnemies[pl->planetID()];
 }
 
 Planet* MyBot::nearestFriendlyPlanet(Planet* pl) const{
-    Planets closest = pl->closestPlanets();
-    for(Planets::iterator pit = closest.begin(); pit != closest.end(); ++pit) {
-        Planet* p = *pit;
-        if (p->owner()->isMe())
-            return p;
-    }
-    return pl;
+    return nearestFriends[pl->planetID()];
 }
 
 //how far is planet pl away from my frontier?
 int MyBot::distanceToFrontier(Planet* pl) const{
-    return pl->distance(nearestFrontierPlanet(pl));
+    if (!frontierProximityValid)
+        updateFrontierProximity();
+    return frontierDistances[pl->planetID()];
 }
 
 
 //what's the closest planet to pl that is closer to the frontier than pl?
 Planet* MyBot::nextPlanetCloserToFrontier(Planet* pl) const{
-    if (pl->frontierStatus)
-        return pl;                
-    int dist = distanceToFrontier(pl);
-    Planets closest = pl->closestPlanets();
-    for(Planets::iterator pit = closest.begin(); pit != closest.end(); ++pit) {
-        Planet* p = *pit;
-        if (p->owner() == pl->owner() && distanceToFrontier(p)<dist)
-            return p;
-    }
-    return pl;
+    if (!frontierProximityValid)
+        updateFrontierProximity();
+    return nextCloserToFrontier[pl->planetID()];
 }
 
 //computes the minimum distance between two sets of planets. 
@@ -997,175 +1851,121 @@ int MyBot::distance(const Planets& ps1, const Planets& ps2) const{
 
 //this computes the fleets for the scenario where both players send all their ships to planet pl.
 //Necessary for predicting if it is possible for me to conquer the planet
-list<Fleet> MyBot::competitiveFleets(Planet* pl) {
-    list<Fleet> fs;
+void MyBot::competitiveFleets(Planet* pl, FleetEvents& events) const {
+    events.clear();
     Planets closest = pl->closestPlanets();
     for (Planets::const_iterator pit = closest.begin(); pit != closest.end(); ++pit) {
         Planet* p = *pit;
         int dist = p->distance(pl);
-        list<Fleet>* maxOutgoing = &maxOutgoingFleets[p];
-        int i(0);
-        for(list<Fleet>::const_iterator fit = maxOutgoing->begin(); fit != maxOutgoing->end(); ++fit){
-            if(!fit->owner()->isNeutral()){
-                Fleet f2(fit->owner(), p, pl, fit->shipsCount(), dist+i, dist+i);
-                fs.push_back(f2);
+        const Timeline& maxOutgoing = maxOutgoingFleets[p->planetID()];
+        for(int i(0); i != maxOutgoing.size(); ++i){
+            if(!maxOutgoing.isNeutral(i)){
+                FleetEvent f2 = { dist+i, maxOutgoing.owner(i), maxOutgoing.shipsCount(i) };
+                events.push_back(f2);
             }
-            ++i;
         }
     }
-    return fs;
 }
 
 
-//this computes the fleets in the scenario where the enemy sends all his ships to planet pl, and I send none.
+//this computes the fleets in the scenario where every enemy sends all their ships to planet pl, and I send none.
+//The ships are kept apart by enemy, since with more than one enemy they also fight each other.
 //TODO: get rid of code duplication with competitiveFleets()
-list<Fleet> MyBot::worstCaseFleets(Planet* pl) {
-    list<Fleet> fs;
-    vector<int> shipsInTurn;
-    for(int i(0); i != lookahead+1+maxDistanceBetweenPlanets;++i) shipsInTurn.push_back(0);
+void MyBot::worstCaseFleets(Planet* pl, FleetEvents& events) const {
+    events.clear();
+    int turns = lookahead+2+maxDistanceBetweenPlanets;
+    int playersCount = game->snapshot().playersCount();
+    //indexed by enemy and turn
+    vector<int> shipsInTurn(playersCount * turns, 0);
     Planets closest = pl->closestPlanets();
     for (Planets::const_iterator pit = closest.begin(); pit != closest.end(); ++pit) {
         Planet* p = *pit;
         int dist = p->distance(pl);
-        list<Fleet>* maxOutgoing = &maxOutgoingFleets[p];
-        int i(0);
-        for(list<Fleet>::const_iterator fit = maxOutgoing->begin(); fit != maxOutgoing->end(); ++fit){
-            if(fit->owner()->isEnemy()){
-                shipsInTurn[dist+i] += fit->shipsCount();
+        const Timeline& maxOutgoing = maxOutgoingFleets[p->planetID()];
+        for(int i(0); i != maxOutgoing.size(); ++i){
+            if(maxOutgoing.isEnemy(i)){
+                shipsInTurn[maxOutgoing.owner(i) * turns + dist+i] += maxOutgoing.shipsCount(i);
             }
-            ++i;
         }
     }
-    for(int i(0); i != shipsInTurn.size(); ++i){
-        Fleet f2(enemy, planets[0], pl, shipsInTurn[i], i, i);
-        fs.push_back(f2);
+    for(int k(EnemyID); k < playersCount; ++k){
+        for(int i(0); i != turns; ++i){
+            FleetEvent f2 = { i, k, shipsInTurn[k * turns + i] };
+            events.push_back(f2);
+        }
     }
-    return fs;
 }
  
 //Given predictions of a planets future, compute how long I will hold this planet starting at time t. 
 //This is used to check if conquering a neutral planet pays off in the worst case.
-int MyBot::willHoldFor(const vector<Planet>& predictions,int t) const{
+int MyBot::willHoldFor(const Timeline& predictions,int t) const{
     if(t >= predictions.size()){
         return 0;
     }
-    for ( vector<Planet>::const_iterator pFuture = predictions.begin()+t; pFuture != predictions.end(); ++pFuture) {
-        if (pFuture->owner()->isEnemy()) return pFuture - (predictions.begin()+t) -1;
+    for (int i(t); i != predictions.size(); ++i) {
+        if (predictions.isEnemy(i)) return i - t - 1;
     }
     return turnsRemaining;
 }
     
 
-//A dynamic programming solution to the knapsack01-problem.
-//This is used in the first turn to allocate ships in a way that maximizes the production rate.
-vector<KnapsackTarget> MyBot::knapsack01(const vector<KnapsackTarget>& candidates, int maxWeight) const{
-    vector<int> weights;
-    vector<int> values;
-
-    for (vector<KnapsackTarget>::const_iterator kt = candidates.begin(); kt != candidates.end(); ++kt) {
-        weights.push_back(kt->weight);
-        values.push_back(kt->value);
-    }
-
-    int K[weights.size()+1][maxWeight];
-
-    for (int i = 0; i < maxWeight; i++) {
-        K[0][i] = 0;
-    }
-    for (int k = 1; k <= weights.size(); k++) {
-        for (int y = 1; y <= maxWeight; y++) {
-            if (y < weights[k-1]) {
-                K[k][y-1] = K[k-1][y-1];
-            } else if (y > weights[k-1]) {
-                K[k][y-1] = max(K[k-1][y-1], K[k-1][y-1-weights[k-1]] + values[k-1]);
-            } else {K[k][y-1] = max(K[k-1][y-1], values[k-1]);}
+//computes for every planet the next planet in the supply chain towards the frontier.
+//This is a Dijkstra search backwards from all frontier planets at once, over the supply steps of the game. Dominated
+//steps are only taken if their witness can't be used, which gives the same costs as trying all steps.
+//Planets without a way to the frontier stay where they are.
+void MyBot::updateSupplyRoutes() {
+    int n = planets.size();
+    vector<float> cost(n, std::numeric_limits<float>::max());
+    vector<bool> done(n, false);
+    vector<bool> usable(n, false);
+    supplyRoutes.resize(n);
+    for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
+        Planet* p = *pit;
+        supplyRoutes[p->planetID()] = p->planetID();
+        //ships are only sent via planets that are or will be mine
+        usable[p->planetID()] = p->owner()->isMe() || p->predictedMine || p->frontierStatus;
+        if (p->frontierStatus) {
+            cost[p->planetID()] = 0;
         }
     }
-
-    int i = weights.size();
-    int currentW = maxWeight-1;
-    vector<KnapsackTarget> markedTargets;
-
-    while ((i > 0) && (currentW >= 0)) {
-        if (((i == 0) && (K[i][currentW] > 0)) || (K[i][currentW] != K[i-1][currentW])) {
-            markedTargets.push_back(candidates[i-1]);
-            currentW = currentW - weights[i-1];
+    while (true) {
+        int next(-1);
+        for(int i(0); i < n; ++i) {
+            if (!done[i] && cost[i] < std::numeric_limits<float>::max() && (next < 0 || cost[i] < cost[next])) {
+                next = i;
+            }
         }
-        i--;
-    }
-    return markedTargets;
-}
-
-
-
-//this computes the next planet in the supply chain starting in planet pl and ending in goal.
-//I use A* for this, with dist*sqrt(dist) as cost function. This cost function favours smaller steps, which are needed for flexibility.
-//The code for this function is mostly taken from http://code.google.com/p/a-star-algorithm-implementation/
-int MyBot::supplyMove(Planet* pl, Planet* goal) {
-    AStarSearch<Planet> astarsearch;
-    Planet* ret;
-
-    // Create a start state
-    Planet nodeStart(*pl);
-
-
-    // Define the goal state
-    Planet nodeEnd(*goal);
-		
-		
-    astarsearch.SetStartAndGoalStates( nodeStart, nodeEnd );
-
-    unsigned int SearchState;
-    unsigned int SearchSteps = 0;
-
-    do
-    {
-        SearchState = astarsearch.SearchStep();
-
-        SearchSteps++;
-
-    }
-    while( SearchState == AStarSearch<Planet>::SEARCH_STATE_SEARCHING );
-
-
-    if ( SearchState == AStarSearch<Planet>::SEARCH_STATE_SUCCEEDED )
-    {
-
-        Planet *node = astarsearch.GetSolutionStart();
-
-        ret = astarsearch.GetSolutionNext();
-
-        astarsearch.FreeSolutionNodes();
-        astarsearch.EnsureMemoryFreed();
-        if (ret) {
-            return ret->planetID();
-        } else {
-            return pl->planetID();
+        if (next < 0)
+            break;
+        done[next] = true;
+        if (!usable[next])
+            continue;
+        const Game::Hops& hops = game->hops(next);
+        for(Game::Hops::const_iterator hit = hops.begin(); hit != hops.end(); ++hit) {
+            float c = cost[next] + hit->cost;
+            if (!done[hit->planetID] && c < cost[hit->planetID]) {
+                cost[hit->planetID] = c;
+                supplyRoutes[hit->planetID] = next;
+            }
+        }
+        const Game::Hops& dominated = game->dominatedHops(next);
+        for(Game::Hops::const_iterator hit = dominated.begin(); hit != dominated.end(); ++hit) {
+            float c = cost[next] + hit->cost;
+            if (!done[hit->planetID] && !usable[hit->witness] && c < cost[hit->planetID]) {
+                cost[hit->planetID] = c;
+                supplyRoutes[hit->planetID] = next;
+            }
         }
-	
-    }
-    else if ( SearchState == AStarSearch<Planet>::SEARCH_STATE_FAILED ) 
-    {
-        astarsearch.EnsureMemoryFreed();
-        return pl->planetID();
     }
-
-
-
-    astarsearch.EnsureMemoryFreed();
-
-    return pl->planetID();
 }
 
-
 //computes my growth rate in t steps, given current fleet movements
 int MyBot::myPredictedGrowthRate(int t) {
     int gr(0);
     for(Planets::const_iterator pit = planets.begin();pit!=planets.end();++pit) {
         Planet* p = *pit;
-        Planet pFut = predictions[p][t];
-        if (pFut.owner()->isMe()) {
-            gr += pFut.growthRate();
+        if (predictions[p->planetID()].isMine(t)) {
+            gr += p->growthRate();
         }
     }
     return gr;
@@ -1176,74 +1976,149 @@ int MyBot::enemyPredictedGrowthRate(int t) {
     int gr(0);
     for(Planets::const_iterator pit = planets.begin();pit!=planets.end();++pit) {
         Planet* p = *pit;
-        Planet pFut = predictions[p][t];
-        if (pFut.owner()->isEnemy()) {
-            gr += pFut.growthRate();
+        if (predictions[p->planetID()].isEnemy(t)) {
+            gr += p->growthRate();
         }
     }
     return gr;
 }
 
-int MyBot::shipsAvailable(const vector<Planet>& predictions, int t) const{
-    int available = predictions[0].shipsCount();
-    int i(0);
-    for(std::vector<Planet>::const_iterator pit = predictions.begin(); pit != predictions.end(); ++pit) {
-        int sc = pit->shipsCount();
-        //cerr << "sc: " << sc << endl;
-        if (pit->owner()->isMe()) {
+int MyBot::shipsAvailable(const Timeline& predictions, int t) const{
+    int available = predictions.shipsCount(0);
+    for(int i(0); i != predictions.size() && i <= t; ++i) {
+        int sc = predictions.shipsCount(i);
+        if (predictions.isMine(i)) {
             available = min(available,sc);
         } else {
             available = min(available, -sc);
-            //cerr << available << endl;
             break;
         }
-        //cerr << available << endl;
-        i++;
-        if (i>t)break;
     }
     return available;
 }
       
 
-Planet* MyBot::coveredBy(Planet* pl, Planet* from) const{
-    Planets closest = from->closestPlanets();
-    for(Planets::const_iterator pit = closest.begin(); pit != closest.end(); ++pit){
-        Planet* p = *pit;
-        if (p == pl){
-            return pl;
+//static "on the way" tables, computed once per map:
+//between[from*n+to] are the planets p with dist(from,p)+dist(p,to) == dist(from,to), i.e. ships from 'from' to 'to' pass them without a detour,
+//coverers[from*n+to] is the first of them in the closest planets of 'from' that comes before 'to', or 'to' if there is none,
+//closestPrefixes[q*n+k] are the k closest planets to q.
+//The tables stay empty if the first turn has no time left for them.
+void MyBot::computeOnTheWay() {
+    const Snapshot& snapshot = game->snapshot();
+    const Planets& planets = game->planets();
+    int n = snapshot.planetsCount();
+    MapCache& cache = game->mapCache();
+    vector<unsigned long long> words;
+    if (cache.get(MapCache::Coverers, coverers) && coverers.size() == n * n
+        && cache.get(MapCache::Between, words) && PlanetSet::fromWords(words, n, n * n, between)
+        && cache.get(MapCache::ClosestPrefixes, words) && PlanetSet::fromWords(words, n, n * n, closestPrefixes)) {
+        return;
+    }
+    between.assign(n * n, PlanetSet(n));
+    coverers.assign(n * n, 0);
+    closestPrefixes.assign(n * n, PlanetSet(n));
+    const vector<int>& mirrors = game->mirrors();
+    for(int from(0); from != n; ++from) {
+        if (mirrors[from] < from) {
+            continue;
+        }
+        for(int to(0); to != n; ++to) {
+            for(int p(0); p != n; ++p) {
+                if (p != from && p != to && snapshot.distance(from, p) + snapshot.distance(p, to) == snapshot.distance(from, to)) {
+                    between[from * n + to].insert(p);
+                }
+            }
+        }
+    }
+    for(int from(0); from != n; ++from) {
+        if (mirrors[from] < from) {
+            for(int to(0); to != n; ++to) {
+                between[from * n + to] = between[mirrors[from] * n + mirrors[to]].mapped(mirrors);
+            }
+        }
+    }
+    for(Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
+        int from = (*pit)->planetID();
+        const Planets& closest = (*pit)->closestPlanets();
+        for(int k(1); k != n; ++k) {
+            closestPrefixes[from * n + k] = closestPrefixes[from * n + k - 1];
+            closestPrefixes[from * n + k].insert(closest[k - 1]->planetID());
+        }
+        for(int to(0); to != n; ++to) {
+            const PlanetSet& ps = between[from * n + to];
+            int toRank = to == from ? n : closenessRanks[from * n + to];
+            coverers[from * n + to] = to;
+            for(int p = ps.next(0); p >= 0; p = ps.next(p + 1)) {
+                int rank = closenessRanks[from * n + p];
+                if (rank < toRank && (coverers[from * n + to] == to || rank < closenessRanks[from * n + coverers[from * n + to]])) {
+                    coverers[from * n + to] = p;
+                }
+            }
         }
-        if(from->distance(p)+p->distance(pl) == from->distance(pl)){
-            return p;
+    }
+    cache.put(MapCache::Coverers, coverers);
+    PlanetSet::toWords(between, words);
+    cache.put(MapCache::Between, words);
+    PlanetSet::toWords(closestPrefixes, words);
+    cache.put(MapCache::ClosestPrefixes, words);
+}
+
+Planet* MyBot::coveredBy(Planet* pl, Planet* from) const{
+    int n = planets.size();
+    if (!coverers.empty()) {
+        return planets[coverers[from->planetID() * n + pl->planetID()]];
+    }
+    //without the on the way tables, the closest planets of 'from' are searched directly
+    const Planets& closest = from->closestPlanets();
+    for(Planets::const_iterator pit = closest.begin(); pit != closest.end() && *pit != pl; ++pit) {
+        if (from->distance(*pit) + (*pit)->distance(pl) == from->distance(pl)) {
+            return *pit;
         }
     }
     return pl;
 }
-  
 
 
 
+//my planets around the frontier planet closest to pl, up to the next frontier planet, sorted by distance
 Planets MyBot::cluster(Planet* pl) const{
+    int n = planets.size();
     Planets clusterPlanets;
     clusterPlanets.push_back(pl);
     Planet* p = nearestFrontierPlanet(pl);
-    Planets closest = p->closestPlanets();
-    for(Planets::iterator pit = closest.begin(); pit != closest.end(); ++pit){
-        Planet* p2 = *pit;
-        if (p2->frontierStatus){
-            return clusterPlanets;
+    //the first frontier planet in the closest planets of p
+    int k = n - 1;
+    for(int f = frontierPlanets.next(0); f >= 0; f = frontierPlanets.next(f + 1)) {
+        if (f != p->planetID()) {
+            k = min(k, closenessRanks[p->planetID() * n + f] - 1);
         }
-        if (p2->owner()->isMe()){
-            clusterPlanets.push_back(p2);
+    }
+    PlanetSet members(n);
+    if (!closestPrefixes.empty()) {
+        members = closestPrefixes[p->planetID() * n + k];
+    } else {
+        const Planets& closest = p->closestPlanets();
+        for(int i(0); i != k; ++i) {
+            members.insert(closest[i]->planetID());
         }
     }
+    members &= ownerMasks[MyID];
+    vector<std::pair<int, Planet*> > sorted;
+    for(int i = members.next(0); i >= 0; i = members.next(i + 1)) {
+        sorted.push_back(std::make_pair(closenessRanks[p->planetID() * n + i], planets[i]));
+    }
+    sort(sorted.begin(), sorted.end());
+    for(vector<std::pair<int, Planet*> >::const_iterator it = sorted.begin(); it != sorted.end(); ++it) {
+        clusterPlanets.push_back(it->second);
+    }
     return clusterPlanets;
 }
 
 
 
-bool MyBot::willHoldAtSomePoint(const vector<Planet>& preds) const{
-    for(vector<Planet>::const_iterator p = preds.begin(); p != preds.end(); ++p){
-        if(p->owner()->isMe()){
+bool MyBot::willHoldAtSomePoint(const Timeline& preds) const{
+    for(int i(0); i != preds.size(); ++i){
+        if(preds.isMine(i)){
             return true;
         }
     }
@@ -1273,7 +2148,6 @@ int MyBot::potential(Planet* pl){
     Planets closest = pl->closestPlanets();
     for(Planets::iterator pit = closest.begin(); pit != closest.end(); ++pit){
         Planet* p = *pit;
-        Planet pFut = predictions[p][lookahead];
         int diff = (maxDistanceBetweenPlanets - p->distance(pl)) * pl->growthRate();
         pot += diff;
     }
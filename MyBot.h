@@ -4,10 +4,17 @@
 #include "abstractbot.h"
 #include "defines.h"
 #include "planet.h"
-#include "knapsackTarget.h"
+#include "snapshot.h"
+#include "batchsimulator.h"
+#include "planetset.h"
+#include "knapsack.h"
+#include "rollout.h"
+#include "matrixgame.h"
 #include <vector>
 #include <list>
 #include <map>
+#include <random>
+#include <set>
 #include <sys/time.h>
 
 class MyBot : public AbstractBot
@@ -17,9 +24,29 @@ public:
 
     void executeTurn();
 
+    // Scores the best candidates by rollouts of the whole game before one is executed, with the given number
+    // of worker threads besides the main thread. Off by default.
+    void enableRollouts(int threadsCount);
+    // Picks among the best candidates by a matrix game against the enemy's likely responses, with the maximin
+    // choice or a choice drawn from the mixed strategy. Off by default, and used instead of the rollouts.
+    void enableMatrixGame(bool mixedStrategy);
+    // In the last turns of the game the orders are found by an exhaustive search instead of the heuristics.
+    // It starts when fewer than the given number of turns remain, 0 turns it off. The default is 10.
+    void setEndgameTurns(int turns);
+    // Chooses the actions by a beam search that keeps the given number of action sets in each step. 1 keeps the
+    // greedy rounds of chooseAction(), which is the default.
+    void setBeamWidth(int width);
+    // The time limit of the first turn in seconds, the default is 3. The analysis of the map gets 70% of the time
+    // on top of a normal turn and skips its optional steps when that is used up, the rest is a normal turn.
+    void setFirstTurnMaxTime(double seconds);
+
  private:
     //setup functions and state information:
     void initialize();
+    void addAnalysisTime(const string& name, double& start);
+    double analysisTime() const;
+    double elapsed();
+    Game::Timings analysisTimes;
     void preprocessing();
     int myPredictedGrowthRate(int t);
     int enemyPredictedGrowthRate(int t);
@@ -41,31 +68,113 @@ public:
 
     //action finding:
     void openingTurn();
-    vector<KnapsackTarget> knapsack01(const vector<KnapsackTarget>& planets, int maxWeight) const;
+    Knapsack knapsack;
+    void expand();
     bool chooseAction();
+    void addAllOrderCandidates(vector<Orders>& orderCandidates);
     void addOrderCandidates(Planet* source1, Planet* source2, vector<Orders>& orderCandidates);
     int value(const Orders& os, bool worstcase = false);
-    int value(const std::vector<Planet>& predictions) const;
+    int value(const Timeline& predictions) const;
+    //the part of the evaluation of orders that is shared by all orders with the same sources and destination
+    struct EvaluationBase {
+        Planet* destination;
+        std::set<Planet*> sources;
+        int dist;
+        int baseValue;
+    };
+    bool values(const vector<Orders>& candidates, vector<int>& vals);
+    bool evaluationBase(const Orders& os, EvaluationBase& base);
+    int value(const Orders& os, const EvaluationBase& base);
+    FleetEvents evaluationEvents;
+    Timeline evaluationPredictions;
+    //beam search over sets of actions, used instead of the greedy chooseAction() rounds if beamWidth > 1
+    struct BeamState {
+        //indices of the actions in the order candidates
+        vector<int> actions;
+        int value;
+    };
+    bool chooseActions(int maxActions);
+    int addedValue(const Orders& os, const EvaluationBase& base);
+    static bool betterBeamState(const BeamState& s1, const BeamState& s2);
+    //rollout evaluation of the best candidates:
+    int bestByRollouts(const vector<Orders>& candidates);
+    RolloutEvaluator rolloutEvaluator;
+    bool rollouts;
+    //number of candidates played out, and rollouts per candidate
+    int rolloutCandidates;
+    int rolloutsCount;
+    int rolloutDepth;
+    //matrix game of the best candidates against the enemy's responses:
+    enum MatrixGameMode {
+        NoMatrixGame,
+        MaximinMatrixGame,
+        MixedMatrixGame
+    };
+    int bestByMatrixGame(const vector<Orders>& candidates);
+    void enemyResponses(const vector<Orders>& candidates, vector<RolloutEvaluator::Moves>& responses) const;
+    int payoff(const GameState& state, const RolloutEvaluator::Moves& moves);
+    MatrixGame matrixGame;
+    MatrixGameMode matrixGameMode;
+    int matrixGameResponses;
+    //payoffs of joint moves, valid as long as the snapshot doesn't change
+    map<vector<int>, int> payoffCache;
+    int payoffCacheVersion;
+    //for the rows of the mixed strategy, with a fixed seed so games can be replayed
+    std::mt19937 matrixGameRandom;
+    //exhaustive search over my orders in the last turns, against the worst attack of the enemy on one planet:
+    struct EndgameSearch {
+        int turns;
+        //my planets that may send ships, and the orders each of them can choose from besides sending nothing
+        vector<Planet*> sources;
+        vector<Orders> options;
+        //net ship gain of each planet without new orders, the fleets of the enemy's worst attack on it,
+        //and how much that attack changes the gain. Planet IDs by that change, worst first.
+        vector<int> baseNets;
+        vector<FleetEvents> attacks;
+        vector<int> attackLosses;
+        vector<int> attackOrder;
+        Orders orders;
+        Orders best;
+        int bestWorst;
+        int bestValue;
+        int combinations;
+    };
+    bool endgame();
+    bool endgameSearch(EndgameSearch& search, int source);
+    int endgameValue(const Orders& os, const EndgameSearch& search, int& worst);
+    int endgameNet(int planet, int turns, const FleetEvents& events);
+    int endgameTurns;
+    //bounds of the search: orders per source, and combinations of them
+    int endgameTargets;
+    int endgameMaxCombinations;
+    FleetEvents endgameEvents;
+    Timeline endgamePredictions;
+    //picks one of the best candidates by the search that is enabled, -1 keeps the best by value
+    bool searchCandidates() const;
+    int bestCandidate(const vector<Orders>& candidates);
     void supply();
-    int supplyMove(Planet* pl, Planet* goal);
+    void updateSupplyRoutes();
+    //next planet on the way to the frontier, indexed by planet ID
+    std::vector<int> supplyRoutes;
     void setExpansionTargets();
     void panic();
     int potential(Planet* pl);
     Orders optimizeOrders(const Orders& o);
-    list<Fleet> ordersToFleets(const Orders& os);
+    void ordersToEvents(const Orders& os, Planet* pl, FleetEvents& events) const;
 
 
     //predictions:
     void updatePredictions();
-    std::map<Planet*, std::vector<Planet > > predictions;
-    std::map<Planet*, std::vector<Planet > > competitivePredictions;
-    std::map<Planet*, std::vector<Planet > > worstCasePredictions;
-    std::map<Planet*, std::list<Fleet > > maxOutgoingFleets;
-    list<Fleet> computeMaxOutgoingFleets(Planet* pl);
-    std::list<Fleet> competitiveFleets(Planet* pl);
-    std::list<Fleet> worstCaseFleets(Planet* pl);
-    int willHoldFor(const vector<Planet>& predictions, int t) const;
-    int shipsAvailable(const vector<Planet>& predictions, int t) const;
+    BatchSimulator batchSimulator;
+    //timelines indexed by planet ID
+    std::vector<Timeline> predictions;
+    std::vector<Timeline> competitivePredictions;
+    std::vector<Timeline> worstCasePredictions;
+    std::vector<Timeline> maxOutgoingFleets;
+    void competitiveFleets(Planet* pl, FleetEvents& events) const;
+    void worstCaseFleets(Planet* pl, FleetEvents& events) const;
+    int willHoldFor(const Timeline& predictions, int t) const;
+    int shipsAvailable(const Timeline& predictions, int t) const;
     int myPredictedGrowth;
     int enemyPredictedGrowth;
 
@@ -76,16 +185,43 @@ public:
     bool isProtectedFrom(Planet* pl, Planet* from) const;
     Planet* isProtectedFromBy(Planet* pl, Planet* from) const;
     bool isProtected(Planet* pl) const;
+    void computeProtection();
+    void updateOwnerMasks();
+    std::vector<PlanetSet> protectors;
+    std::vector<PlanetSet> threats;
+    //position of a planet in the closest planets of another planet, starting with 1
+    std::vector<int> closenessRanks;
+    //indexed by player ID
+    std::vector<PlanetSet> ownerMasks;
+    std::vector<PlanetSet> hostileMasks;
     Planet* nearestFrontierPlanet(Planet* pl) const;
     int distanceToFrontier(Planet* pl) const;
     Planet* nextPlanetCloserToFrontier(Planet* pl) const;
-    bool isFrontier(Planet* pl) const;
+    void updateFrontier();
+    //result of the last frontier computation and the owners it was computed for, indexed by planet ID
+    std::vector<bool> frontier;
+    std::vector<char> frontierFlags;
     int distance(const Planets& ps1, const Planets& ps2) const;
     Planet* nearestEnemyPlanet(Planet* pl) const;
     Planet* nearestFriendlyPlanet(Planet* pl) const;
     Planet* coveredBy(Planet* pl, Planet* from) const;
+    void setFrontierStatus(Planet* pl, bool frontier);
+    //proximity tables, indexed by planet ID:
+    void updateOwnerProximity();
+    void updateFrontierProximity() const;
+    std::vector<Planet*> nearestEnemies;
+    std::vector<Planet*> nearestFriends;
+    mutable std::vector<Planet*> nearestFrontiers;
+    mutable std::vector<int> frontierDistances;
+    mutable std::vector<Planet*> nextCloserToFrontier;
+    mutable bool frontierProximityValid;
     Planets cluster(Planet* pl) const;
-    bool willHoldAtSomePoint(const vector<Planet>& preds) const;
+    void computeOnTheWay();
+    std::vector<PlanetSet> between;
+    std::vector<int> coverers;
+    std::vector<PlanetSet> closestPrefixes;
+    PlanetSet frontierPlanets;
+    bool willHoldAtSomePoint(const Timeline& preds) const;
 
     void issueOrder(Order o, string reason);
     void issueOrders(const Orders& os);
@@ -94,6 +230,10 @@ public:
     double t1;
     double t2;
     double maxTime;
+    //time limit of the first turn, which includes the analysis of the map
+    double firstTurnMaxTime;
+    //number of action sets kept in each step of the beam search
+    int beamWidth;
 };
 
 #endif // MY_BOT_H
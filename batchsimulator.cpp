@@ -0,0 +1,246 @@
+#include "batchsimulator.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_SIMD 1
+#include <immintrin.h>
+#endif
+
+// All planets are padded to a multiple of this, so the widest kernel never needs a remainder loop
+static const int maxLanes = 8;
+
+// Advances all planets by one turn. Owners and ships are updated in place and written to the output row.
+typedef void (*StepFunction)(int stride, int playersCount, const int* growth, const int* arrivals, int* owner, int* ships);
+
+//the same rules as Snapshot::simulate(), one planet at a time
+static void scalarStep(int stride, int playersCount, const int* growth, const int* arrivals, int* owner, int* ships)
+{
+    for (int p = 0; p < stride; ++p) {
+        int o = owner[p];
+        int sc = ships[p] + (o != NeutralID ? growth[p] : 0);
+        int winner = 0;
+        uint winnerShips = 0;
+        uint secondShips = 0;
+        for (int k = 0; k < playersCount; ++k) {
+            uint part = arrivals[k * stride + p] + (k == o ? sc : 0);
+            if (part > secondShips) {
+                if (part > winnerShips) {
+                    secondShips = winnerShips;
+                    winnerShips = part;
+                    winner = k;
+                } else {
+                    secondShips = part;
+                }
+            }
+        }
+        if (winnerShips > secondShips) {
+            owner[p] = winner;
+            ships[p] = winnerShips - secondShips;
+        } else {
+            ships[p] = 0;
+        }
+    }
+}
+
+#ifdef BATCH_SIMD
+
+//Forces are compared as unsigned numbers, like in the scalar code. For the two largest forces this means
+//winner = max(winner, part) and second = max(second, min(winner, part)), and the winner changes only if part is strictly larger.
+__attribute__((target("sse4.1")))
+static void sse41Step(int stride, int playersCount, const int* growth, const int* arrivals, int* owner, int* ships)
+{
+    const __m128i zero = _mm_setzero_si128();
+    for (int p = 0; p < stride; p += 4) {
+        __m128i o = _mm_loadu_si128((const __m128i*)(owner + p));
+        __m128i sc = _mm_loadu_si128((const __m128i*)(ships + p));
+        __m128i g = _mm_loadu_si128((const __m128i*)(growth + p));
+        __m128i neutral = _mm_cmpeq_epi32(o, zero);
+        sc = _mm_add_epi32(sc, _mm_andnot_si128(neutral, g));
+
+        __m128i winner = o;
+        __m128i winnerShips = zero;
+        __m128i secondShips = zero;
+        for (int k = 0; k < playersCount; ++k) {
+            __m128i part = _mm_loadu_si128((const __m128i*)(arrivals + k * stride + p));
+            __m128i isOwner = _mm_cmpeq_epi32(o, _mm_set1_epi32(k));
+            part = _mm_add_epi32(part, _mm_and_si128(isOwner, sc));
+            __m128i newWinnerShips = _mm_max_epu32(winnerShips, part);
+            __m128i notLarger = _mm_cmpeq_epi32(newWinnerShips, winnerShips);
+            secondShips = _mm_max_epu32(secondShips, _mm_min_epu32(winnerShips, part));
+            winner = _mm_blendv_epi8(_mm_set1_epi32(k), winner, notLarger);
+            winnerShips = newWinnerShips;
+        }
+        __m128i tie = _mm_cmpeq_epi32(winnerShips, secondShips);
+        __m128i diff = _mm_andnot_si128(tie, _mm_sub_epi32(winnerShips, secondShips));
+        o = _mm_blendv_epi8(winner, o, tie);
+        _mm_storeu_si128((__m128i*)(owner + p), o);
+        _mm_storeu_si128((__m128i*)(ships + p), diff);
+    }
+}
+
+__attribute__((target("avx2")))
+static void avx2Step(int stride, int playersCount, const int* growth, const int* arrivals, int* owner, int* ships)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    for (int p = 0; p < stride; p += 8) {
+        __m256i o = _mm256_loadu_si256((const __m256i*)(owner + p));
+        __m256i sc = _mm256_loadu_si256((const __m256i*)(ships + p));
+        __m256i g = _mm256_loadu_si256((const __m256i*)(growth + p));
+        __m256i neutral = _mm256_cmpeq_epi32(o, zero);
+        sc = _mm256_add_epi32(sc, _mm256_andnot_si256(neutral, g));
+
+        __m256i winner = o;
+        __m256i winnerShips = zero;
+        __m256i secondShips = zero;
+        for (int k = 0; k < playersCount; ++k) {
+            __m256i part = _mm256_loadu_si256((const __m256i*)(arrivals + k * stride + p));
+            __m256i isOwner = _mm256_cmpeq_epi32(o, _mm256_set1_epi32(k));
+            part = _mm256_add_epi32(part, _mm256_and_si256(isOwner, sc));
+            __m256i newWinnerShips = _mm256_max_epu32(winnerShips, part);
+            __m256i notLarger = _mm256_cmpeq_epi32(newWinnerShips, winnerShips);
+            secondShips = _mm256_max_epu32(secondShips, _mm256_min_epu32(winnerShips, part));
+            winner = _mm256_blendv_epi8(_mm256_set1_epi32(k), winner, notLarger);
+            winnerShips = newWinnerShips;
+        }
+        __m256i tie = _mm256_cmpeq_epi32(winnerShips, secondShips);
+        __m256i diff = _mm256_andnot_si256(tie, _mm256_sub_epi32(winnerShips, secondShips));
+        o = _mm256_blendv_epi8(winner, o, tie);
+        _mm256_storeu_si256((__m256i*)(owner + p), o);
+        _mm256_storeu_si256((__m256i*)(ships + p), diff);
+    }
+}
+
+#endif // BATCH_SIMD
+
+static StepFunction stepFunction(BatchSimulator::Kernel kernel)
+{
+#ifdef BATCH_SIMD
+    switch (kernel) {
+    case BatchSimulator::AVX2Kernel:
+        return avx2Step;
+    case BatchSimulator::SSE41Kernel:
+        return sse41Step;
+    default:
+        break;
+    }
+#endif
+    return scalarStep;
+}
+
+
+BatchSimulator::BatchSimulator() :
+    kernel_m(bestKernel()),
+    turns_m(0),
+    planetsCount_m(0),
+    playersCount_m(0),
+    stride_m(0)
+{
+}
+
+BatchSimulator::Kernel BatchSimulator::bestKernel()
+{
+#ifdef BATCH_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+        return AVX2Kernel;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return SSE41Kernel;
+    }
+#endif
+    return ScalarKernel;
+}
+
+bool BatchSimulator::setKernel(Kernel kernel)
+{
+#ifdef BATCH_SIMD
+    if ((kernel == AVX2Kernel && !__builtin_cpu_supports("avx2"))
+        || (kernel == SSE41Kernel && !__builtin_cpu_supports("sse4.1"))) {
+        return false;
+    }
+#else
+    if (kernel != ScalarKernel) {
+        return false;
+    }
+#endif
+    kernel_m = kernel;
+    return true;
+}
+
+BatchSimulator::Kernel BatchSimulator::kernel() const
+{
+    return kernel_m;
+}
+
+const char* BatchSimulator::kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case AVX2Kernel:
+        return "avx2";
+    case SSE41Kernel:
+        return "sse4.1";
+    default:
+        return "scalar";
+    }
+}
+
+void BatchSimulator::reset(const Snapshot& snapshot, int turns)
+{
+    turns_m = turns;
+    planetsCount_m = snapshot.planetsCount();
+    playersCount_m = snapshot.playersCount();
+    stride_m = (planetsCount_m + maxLanes - 1) / maxLanes * maxLanes;
+
+    // Padding planets are neutral, without ships and growth, and stay that way
+    growth_m.assign(stride_m, 0);
+    owner_m.assign(stride_m, NeutralID);
+    ships_m.assign(stride_m, 0);
+    std::copy(snapshot.planetGrowth.begin(), snapshot.planetGrowth.end(), growth_m.begin());
+    std::copy(snapshot.planetOwner.begin(), snapshot.planetOwner.end(), owner_m.begin());
+    std::copy(snapshot.planetShips.begin(), snapshot.planetShips.end(), ships_m.begin());
+
+    arrivals_m.assign((turns_m + 1) * playersCount_m * stride_m, 0);
+    uint fleetsCount = snapshot.fleetArrival.size();
+    for (uint f = 0; f < fleetsCount; ++f) {
+        int t = snapshot.fleetArrival[f];
+        if (t > 0 && t <= turns_m) {
+            arrivals_m[(t * playersCount_m + snapshot.fleetOwner[f]) * stride_m + snapshot.fleetDestination[f]] += snapshot.fleetShips[f];
+        }
+    }
+}
+
+void BatchSimulator::addEvents(int planet, const FleetEvents& events)
+{
+    for (FleetEvents::const_iterator e = events.begin(); e != events.end(); ++e) {
+        if (e->turn == 0) {
+            ships_m[planet] -= e->shipsCount;
+        } else if (e->turn <= turns_m) {
+            arrivals_m[(e->turn * playersCount_m + e->owner) * stride_m + planet] += e->shipsCount;
+        }
+    }
+}
+
+void BatchSimulator::run(std::vector<Timeline>& timelines)
+{
+    StepFunction step = stepFunction(kernel_m);
+    ownerOut_m.resize((turns_m + 1) * stride_m);
+    shipsOut_m.resize((turns_m + 1) * stride_m);
+    std::copy(owner_m.begin(), owner_m.end(), ownerOut_m.begin());
+    std::copy(ships_m.begin(), ships_m.end(), shipsOut_m.begin());
+    for (int t = 1; t <= turns_m; ++t) {
+        int* owner = &ownerOut_m[t * stride_m];
+        int* ships = &shipsOut_m[t * stride_m];
+        std::copy(owner - stride_m, owner, owner);
+        std::copy(ships - stride_m, ships, ships);
+        step(stride_m, playersCount_m, &growth_m[0], &arrivals_m[t * playersCount_m * stride_m], owner, ships);
+    }
+
+    timelines.resize(planetsCount_m);
+    for (int p = 0; p < planetsCount_m; ++p) {
+        Timeline& timeline = timelines[p];
+        timeline.resize(turns_m + 1);
+        for (int t = 0; t <= turns_m; ++t) {
+            timeline.set(t, ownerOut_m[t * stride_m + p], shipsOut_m[t * stride_m + p]);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef BATCHSIMULATOR_H
+#define BATCHSIMULATOR_H
+
+#include <vector>
+
+#include "snapshot.h"
+
+// Simulates the timelines of all planets of a snapshot at once.
+// The arrivals are kept in a dense grid indexed by turn, player and planet, so that one
+// step of growth and battle resolution is the same for every planet and several planets are
+// advanced per SIMD instruction. The kernel is picked at runtime from what the CPU supports.
+class BatchSimulator {
+public:
+    enum Kernel {
+        ScalarKernel,
+        SSE41Kernel,
+        AVX2Kernel
+    };
+
+    BatchSimulator();
+
+    // Starts a new pass over all planets of the snapshot, with the fleets in flight.
+    void reset(const Snapshot& snapshot, int turns);
+    // Adds hypothetical ships for one planet, with the same meaning as for Snapshot::simulate().
+    void addEvents(int planet, const FleetEvents& events);
+    // Simulates all planets and stores their timelines, indexed by planet ID.
+    void run(std::vector<Timeline>& timelines);
+
+    // Returns false if the CPU can't run the kernel.
+    bool setKernel(Kernel kernel);
+    Kernel kernel() const;
+    static Kernel bestKernel();
+    static const char* kernelName(Kernel kernel);
+
+private:
+    Kernel kernel_m;
+    int turns_m;
+    int planetsCount_m;
+    int playersCount_m;
+    // Number of planets rounded up to a multiple of the widest vector
+    int stride_m;
+
+    std::vector<int> growth_m;
+    std::vector<int> owner_m;
+    std::vector<int> ships_m;
+    // ships arriving in turn t for player k at planet p: arrivals_m[(t * playersCount_m + k) * stride_m + p]
+    std::vector<int> arrivals_m;
+    // result of the last run, indexed by turn and planet
+    std::vector<int> ownerOut_m;
+    std::vector<int> shipsOut_m;
+};
+
+#endif // BATCHSIMULATOR_H
@@ -0,0 +1,266 @@
+// Microbenchmarks for the simulation code of the bot.
+// Usage: bench [planets] [fleets] [recorded game]
+// A recorded game is the input the bot got in every turn. The whole game simulation is checked against it.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <thread>
+#include <sys/time.h>
+
+#include "game.h"
+#include "planet.h"
+#include "snapshot.h"
+#include "batchsimulator.h"
+#include "gamestate.h"
+#include "rollout.h"
+#include "simulationcache.h"
+
+using std::cout;
+using std::endl;
+
+static double now()
+{
+    timeval tim;
+    gettimeofday(&tim, NULL);
+    return tim.tv_sec + (tim.tv_usec / 1000000.0);
+}
+
+//a random map in the engine's format, with fleets of both players in flight
+static std::string randomMap(int planetsCount, int fleetsCount)
+{
+    std::ostringstream map;
+    srand(42);
+    for (int i = 0; i < planetsCount; ++i) {
+        int owner = i == 1 ? 1 : (i == 2 ? 2 : 0);
+        map << "P " << (rand() % 2400) / 100.0 << " " << (rand() % 2400) / 100.0 << " " << owner << " " << rand() % 100 << " " << rand() % 6 << "\n";
+    }
+    for (int i = 0; i < fleetsCount; ++i) {
+        int trip = 1 + rand() % 20;
+        map << "F " << 1 + rand() % 2 << " " << rand() % 50 << " " << rand() % planetsCount << " " << rand() % planetsCount << " " << trip << " " << 1 + rand() % trip << "\n";
+    }
+    return map.str();
+}
+
+static void report(const char* name, long planetTurns, double seconds)
+{
+    cout << name << ": " << planetTurns / seconds / 1e6 << " M planet-turns/s" << endl;
+}
+
+//the simulations of a turn without the cache, so they compare with the batch kernels, and with the cache
+static void benchSimulation(const Game& game, int turns)
+{
+    Snapshot snapshot;
+    snapshot.setDistances(game.snapshot().distances());
+    snapshot.update(game.planets());
+    int planetsCount = snapshot.planetsCount();
+    const int rounds = 2000;
+    long planetTurns = long(rounds) * planetsCount * turns;
+    std::vector<Timeline> timelines(planetsCount);
+
+    snapshot.setCaching(false);
+    double start = now();
+    for (int r = 0; r < rounds; ++r) {
+        for (int p = 0; p < planetsCount; ++p) {
+            snapshot.simulate(p, turns, timelines[p]);
+        }
+    }
+    report("Snapshot::simulate", planetTurns, now() - start);
+
+    snapshot.setCaching(true);
+    start = now();
+    for (int r = 0; r < rounds; ++r) {
+        for (int p = 0; p < planetsCount; ++p) {
+            snapshot.simulate(p, turns, timelines[p]);
+        }
+    }
+    const SimulationCache& cache = snapshot.simulationCache();
+    report("Snapshot::simulate, cached", planetTurns, now() - start);
+    cout << "  " << cache.hits() << " hits of " << cache.lookups() << " lookups" << endl;
+
+    BatchSimulator::Kernel kernels[] = { BatchSimulator::ScalarKernel, BatchSimulator::SSE41Kernel, BatchSimulator::AVX2Kernel };
+    for (int k = 0; k < 3; ++k) {
+        BatchSimulator batch;
+        if (!batch.setKernel(kernels[k])) {
+            cout << "BatchSimulator " << BatchSimulator::kernelName(kernels[k]) << ": not supported" << endl;
+            continue;
+        }
+        std::vector<Timeline> batchTimelines;
+        start = now();
+        for (int r = 0; r < rounds; ++r) {
+            batch.reset(snapshot, turns);
+            batch.run(batchTimelines);
+        }
+        std::string name = std::string("BatchSimulator ") + BatchSimulator::kernelName(kernels[k]);
+        report(name.c_str(), planetTurns, now() - start);
+
+        for (int p = 0; p < planetsCount; ++p) {
+            for (int t = 0; t <= turns; ++t) {
+                if (batchTimelines[p].owner(t) != timelines[p].owner(t) || batchTimelines[p].shipsCount(t) != timelines[p].shipsCount(t)) {
+                    cout << "  MISMATCH at planet " << p << ", turn " << t << endl;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+//copies and steps of the whole game with random moves of both players
+static void benchGameState(const Game& game, int turns)
+{
+    GameState start;
+    if (!start.set(game.snapshot(), game.turn())) {
+        cout << "GameState: the map is too large" << endl;
+        return;
+    }
+    const int games = 2000;
+    std::vector<GameState::Move> moves;
+    GameState state;
+    double begin = now();
+    for (int g = 0; g < games; ++g) {
+        state = start;
+        for (int t = 0; t < turns; ++t) {
+            moves.clear();
+            for (int i = 0; i < 4; ++i) {
+                int source = rand() % state.planetsCount();
+                GameState::Move move = { source, rand() % state.planetsCount(), state.shipsCount(source) / 2 };
+                moves.push_back(move);
+            }
+            state.step(&moves[0], moves.size());
+        }
+    }
+    double seconds = now() - begin;
+    report("GameState::step", long(games) * turns * state.planetsCount(), seconds);
+    cout << "GameState: " << sizeof(GameState) << " bytes, " << long(games) * turns / seconds / 1e6 << " M turns/s" << endl;
+}
+
+//rollouts of four candidates with different numbers of worker threads, which have to give the same scores
+static void benchRollouts(const Game& game, int depth)
+{
+    GameState state;
+    if (!state.set(game.snapshot(), game.turn())) {
+        return;
+    }
+    std::vector<RolloutEvaluator::Moves> candidates(4);
+    for (int c = 1; c < 4; ++c) {
+        for (int p = 0; p < state.planetsCount(); ++p) {
+            if (state.owner(p) == MyID && state.shipsCount(p) > 0) {
+                GameState::Move move = { p, rand() % state.planetsCount(), state.shipsCount(p) * c / 4 };
+                candidates[c].push_back(move);
+            }
+        }
+    }
+    const int rolloutsCount = 2000;
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    std::vector<double> firstScores;
+    for (int threads = 0; ; threads = std::min(maxThreads, std::max(1, threads * 2))) {
+        RolloutEvaluator evaluator;
+        evaluator.setThreadsCount(threads);
+        std::vector<double> scores;
+        std::vector<int> counts;
+        double start = now();
+        evaluator.evaluate(state, candidates, rolloutsCount, depth, start + 1000, scores, counts);
+        double seconds = now() - start;
+        cout << "RolloutEvaluator, " << threads + 1 << " threads: " << 4 * rolloutsCount / seconds << " rollouts/s of " << depth << " turns" << endl;
+        if (firstScores.empty()) {
+            firstScores = scores;
+        } else if (scores != firstScores) {
+            cout << "  different scores" << endl;
+        }
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+}
+
+//the fleets by owner, destination and turns remaining
+static std::map<std::vector<int>, int> fleetTotals(const GameState& state)
+{
+    std::map<std::vector<int>, int> totals;
+    for (int f = 0; f < state.fleetsCount(); ++f) {
+        std::vector<int> key;
+        key.push_back(state.fleet(f).owner);
+        key.push_back(state.fleet(f).destination);
+        key.push_back(state.fleet(f).turnsRemaining);
+        totals[key] += state.fleet(f).shipsCount;
+    }
+    return totals;
+}
+
+//Steps through a recorded game with the orders that can be read off the fleets that departed in each turn,
+//and compares every turn with the recording.
+static void verifyGameState(const char* fileName)
+{
+    std::ifstream file(fileName);
+    std::vector<std::string> states(1);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line == "go") {
+            states.push_back("");
+        } else {
+            states.back() += line + "\n";
+        }
+    }
+    states.pop_back();
+    if (states.size() < 2) {
+        cout << "no recorded game in " << fileName << endl;
+        return;
+    }
+
+    Game game;
+    game.initializeState(states[0]);
+    GameState state;
+    int mismatches = 0;
+    for (unsigned int t = 1; t < states.size(); ++t) {
+        state.set(game.snapshot(), t);
+        std::vector<GameState::Move> moves;
+        std::istringstream next(states[t]);
+        while (std::getline(next, line)) {
+            std::istringstream tokens(line);
+            std::string type;
+            int owner, shipsCount, source, destination, tripLength, turnsRemaining;
+            if (tokens >> type >> owner >> shipsCount >> source >> destination >> tripLength >> turnsRemaining
+                && type == "F" && turnsRemaining == tripLength - 1) {
+                GameState::Move move = { source, destination, shipsCount };
+                moves.push_back(move);
+            }
+        }
+        state.step(moves.empty() ? 0 : &moves[0], moves.size());
+
+        game.updateState(states[t]);
+        GameState recorded;
+        recorded.set(game.snapshot(), t + 1);
+        bool same = fleetTotals(state) == fleetTotals(recorded);
+        for (int p = 0; p < state.planetsCount(); ++p) {
+            same = same && state.owner(p) == recorded.owner(p) && state.shipsCount(p) == recorded.shipsCount(p);
+        }
+        if (!same) {
+            ++mismatches;
+        }
+    }
+    cout << "GameState: " << states.size() - 1 << " recorded turns, " << mismatches << " mismatches" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    int planetsCount = argc > 1 ? atoi(argv[1]) : 100;
+    int fleetsCount = argc > 2 ? atoi(argv[2]) : 300;
+    const int turns = 40;
+
+    Game game;
+    game.initializeState(randomMap(planetsCount, fleetsCount));
+    cout << planetsCount << " planets, " << fleetsCount << " fleets, " << turns << " turns" << endl;
+
+    benchSimulation(game, turns);
+    benchGameState(game, turns);
+    benchRollouts(game, 30);
+    if (argc > 3) {
+        verifyGameState(argv[3]);
+    }
+    return 0;
+}
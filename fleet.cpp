@@ -10,7 +10,8 @@ Fleet::Fleet(const Player* owner, const Planet* sourcePlanet, const Planet* dest
     destinationPlanet_m(destinationPlanet),
     shipsCount_m(shipsCount),
     tripLenght_m(tripLength),
-    turnsRemaining_m(turnsRemaining)
+    turnsRemaining_m(turnsRemaining),
+    fleetID_m(0)
 {
 }
 
@@ -18,7 +19,8 @@ Fleet::Fleet(const Order& order) :
     owner_m(order.sourcePlanet->owner()),
     sourcePlanet_m(order.sourcePlanet),
     destinationPlanet_m(order.destinationPlanet),
-    shipsCount_m(order.shipsCount)
+    shipsCount_m(order.shipsCount),
+    fleetID_m(0)
 {
     tripLenght_m = Point::distanceBetween(sourcePlanet_m->coordinate(), destinationPlanet_m->coordinate());
     turnsRemaining_m = tripLenght_m;
@@ -30,7 +32,8 @@ Fleet::Fleet(const Player* owner, uint sc):
   turnsRemaining_m(0),
   sourcePlanet_m(0),
   tripLenght_m(0),
-  destinationPlanet_m(0)
+  destinationPlanet_m(0),
+  fleetID_m(0)
 {
 }
 
@@ -55,6 +58,11 @@ uint Fleet::shipsCount() const
     return shipsCount_m;
 }
 
+uint Fleet::fleetID() const
+{
+    return fleetID_m;
+}
+
 uint Fleet::tripLength() const
 {
     return tripLenght_m;
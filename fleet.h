@@ -13,6 +13,9 @@ public:
     const Player* owner() const;
     uint shipsCount() const;
 
+    // Stable identifier of this fleet across turns, 0 for fleets not tracked by the game.
+    uint fleetID() const;
+
     const Planet* sourcePlanet() const;
     const Planet* destinationPlanet() const;
 
@@ -28,6 +31,7 @@ private:
     uint shipsCount_m;
 
     uint tripLenght_m;
+    uint fleetID_m;
 };
 
 #endif // FLEET_H
@@ -1,6 +1,9 @@
 #include "game.h"
 
 #include <iostream>
+#include <cmath>
+#include <stdexcept>
+#include <sys/time.h>
 
 #include "fleet.h"
 #include "planet.h"
@@ -13,7 +16,9 @@
 Game::Game() :
     turn_m(0),
     planetsCount_m(0),
-    playersCount_m(3)
+    playersCount_m(3),
+    nextFleetID_m(1),
+    symmetric_m(false)
 {
     // Add the default number of players
     for (uint i = 0; i < 3; ++i) {
@@ -24,6 +29,9 @@ Game::Game() :
 Game::~Game()
 {
     deleteFleets();
+    for (uint i = 0; i < spareFleets_m.size(); ++i) {
+        delete spareFleets_m.at(i);
+    }
     deletePlanets();
     deletePlayers();
 }
@@ -45,6 +53,8 @@ void Game::deleteFleets()
     }
 
     fleets_m.clear();
+    newEnemyFleets_m.clear();
+    appliedFleets_m.clear();
 }
 
 void Game::deletePlanets()
@@ -96,23 +106,32 @@ uint Game::fleetsCount() const
     return fleets_m.size();
 }
 
+uint Game::playersCount() const
+{
+    return playersCount_m;
+}
+
 const Player* Game::playerByID(uint playerID) const
 {
-    return playerByID(playerID);
+    return playerID < playersCount_m ? players_m[playerID] : 0;
 }
 
 Player* Game::playerByID(uint playerID)
 {
-    Player* player = 0;
+    return playerID < playersCount_m ? players_m[playerID] : 0;
+}
 
-    uint size = players_m.size();
-    for (uint i = 0; i < size; ++i) {
-        if (players_m.at(i)->playerID() == playerID) {
-            player = players_m.at(i);
-        }
+// Players are kept indexed by their ID, so the players up to a new ID are added together
+Player* Game::addPlayer(uint playerID)
+{
+    if (playerID >= MaxPlayersCount) {
+        throw std::out_of_range("player ID out of range");
     }
-
-    return player;
+    while (playersCount_m <= playerID) {
+        players_m.push_back(new Player(playersCount_m));
+        playersCount_m++;
+    }
+    return players_m[playerID];
 }
 
 
@@ -136,6 +155,26 @@ Planet* Game::planetByID(uint planetID)
 }
 
 
+const Fleet* Game::fleetByID(uint fleetID) const
+{
+    return const_cast<Game*>(this)->fleetByID(fleetID);
+}
+
+Fleet* Game::fleetByID(uint fleetID)
+{
+    Fleet* fleet = 0;
+
+    uint size = fleets_m.size();
+    for (uint i = 0; i < size; ++i) {
+        if (fleets_m.at(i)->fleetID() == fleetID) {
+            fleet = fleets_m.at(i);
+        }
+    }
+
+    return fleet;
+}
+
+
 Planets const& Game::planets() const
 {
     return planets_m;
@@ -178,6 +217,11 @@ Fleets const& Game::fleets() const
     return fleets_m;
 }
 
+Fleets const& Game::newEnemyFleets() const
+{
+    return newEnemyFleets_m;
+}
+
 Fleets Game::myFleets() const
 {
     Fleets myFleets(fleets_m);
@@ -194,6 +238,11 @@ Fleets Game::enemyFleets() const
     return enemyFleets;
 }
 
+const Snapshot& Game::snapshot() const
+{
+    return snapshot_m;
+}
+
 void Game::issueOrder(const Order& order)
 {
     // Proceed only if the order is valid
@@ -203,6 +252,47 @@ void Game::issueOrder(const Order& order)
     }
 }
 
+void Game::applyOrder(const Order& order)
+{
+    if (!order.isValid()) {
+        return;
+    }
+    Fleet* fleet;
+    if (spareFleets_m.empty()) {
+        fleet = new Fleet(order);
+    } else {
+        fleet = spareFleets_m.back();
+        spareFleets_m.pop_back();
+        *fleet = Fleet(order);
+    }
+    updateState(order, fleet);
+    appliedFleets_m.push_back(fleet);
+}
+
+uint Game::appliedOrdersCount() const
+{
+    return appliedFleets_m.size();
+}
+
+void Game::undoOrders(uint appliedOrdersCount)
+{
+    while (appliedFleets_m.size() > appliedOrdersCount) {
+        Fleet* fleet = appliedFleets_m.back();
+        appliedFleets_m.pop_back();
+        // The fleet was the last one added everywhere
+        Planet* source = planets_m.at(fleet->sourcePlanet()->planetID());
+        Planet* destination = planets_m.at(fleet->destinationPlanet()->planetID());
+        source->update(source->owner(), source->shipsCount() + fleet->shipsCount());
+        source->leavingFleets_m.pop_back();
+        destination->incomingFleets_m.pop_back();
+        destination->aggregateArrivals();
+        fleets_m.pop_back();
+        --nextFleetID_m;
+        snapshot_m.undoOrder();
+        spareFleets_m.push_back(fleet);
+    }
+}
+
 void Game::initializeState(const std::string &state)
 {
     std::vector<std::string> lines = StringTokenizer::Tokenize(state, '\n');
@@ -230,12 +320,7 @@ void Game::initializeState(const std::string &state)
             uint  ownerID    = atoi(tokens.at(3).c_str());
             Point coordinate = Point(atof(tokens.at(1).c_str()), atof(tokens.at(2).c_str()));
 
-            Player* owner = playerByID(ownerID);
-            if (!owner) {
-                owner = new Player(ownerID);
-                players_m.push_back(owner);
-                playersCount_m++;
-            }
+            Player* owner = addPlayer(ownerID);
 
             Planet* newPlanet = new Planet(planetID, shipsCount, growthRate, coordinate, owner);
             planets_m.push_back(newPlanet);
@@ -252,14 +337,10 @@ void Game::initializeState(const std::string &state)
             Planet* sourcePlanet      = planets_m.at(atoi(tokens.at(3).c_str()));
             Planet* destinationPlanet = planets_m.at(atoi(tokens.at(4).c_str()));
 
-            Player* owner = playerByID(ownerID);
-            if (!owner) {
-                owner = new Player(ownerID);
-                players_m.push_back(owner);
-                playersCount_m++;
-            }
+            Player* owner = addPlayer(ownerID);
 
             Fleet* newFleet = new Fleet(owner, sourcePlanet, destinationPlanet, shipsCount, tripLength, turnsRemaining);
+            trackFleet(newFleet);
             fleets_m.push_back(newFleet);
 
             // Add fleet to source and destination planet respectively
@@ -271,9 +352,49 @@ void Game::initializeState(const std::string &state)
 
     // Assign other planets to each planet
     planetsCount_m = planetID;
+    double start = now();
+    mapAnalysisTimes_m.clear();
+    mapCache_m.load(MapCache::fingerprint(planets_m));
+    addMapAnalysisTime("map cache", start);
+    std::vector<int> closest;
+    bool closestCached = mapCache_m.get(MapCache::ClosestPlanets, closest) && closest.size() == planetsCount_m * (planetsCount_m - 1);
     for (uint i = 0; i < planetsCount_m; ++i) {
-        planets_m.at(i)->setOtherPlanets(planets());
+        if (closestCached) {
+            Planets& planetClosest = planets_m.at(i)->closestPlanets_m;
+            planetClosest.resize(planetsCount_m - 1);
+            for (uint j = 0; j < planetsCount_m - 1; ++j) {
+                planetClosest[j] = planets_m.at(closest[i * (planetsCount_m - 1) + j]);
+            }
+        } else {
+            planets_m.at(i)->setOtherPlanets(planets());
+        }
+        planets_m.at(i)->aggregateArrivals();
     }
+    if (!closestCached) {
+        closest.clear();
+        for (uint i = 0; i < planetsCount_m; ++i) {
+            const Planets& planetClosest = planets_m.at(i)->closestPlanets();
+            for (Planets::const_iterator pit = planetClosest.begin(); pit != planetClosest.end(); ++pit) {
+                closest.push_back((*pit)->planetID());
+            }
+        }
+        mapCache_m.put(MapCache::ClosestPlanets, closest);
+    }
+    addMapAnalysisTime("closest planets", start);
+
+    std::vector<int> distances;
+    if (mapCache_m.get(MapCache::Distances, distances) && distances.size() == planetsCount_m * planetsCount_m) {
+        snapshot_m.setDistances(distances);
+        snapshot_m.update(planets_m);
+    } else {
+        snapshot_m.update(planets_m);
+        mapCache_m.put(MapCache::Distances, snapshot_m.distances());
+    }
+    addMapAnalysisTime("distances", start);
+    detectSymmetry();
+    addMapAnalysisTime("symmetry", start);
+    computeHops();
+    addMapAnalysisTime("supply steps", start);
 
     turn_m++;
 }
@@ -283,6 +404,7 @@ void Game::updateState(const std::string& state)
     std::vector<std::string> lines = StringTokenizer::Tokenize(state, '\n');
     uint planetID = 0;
 
+    rememberFleets();
     deleteFleets();
     clearPlayersPlanets();
 
@@ -306,12 +428,7 @@ void Game::updateState(const std::string& state)
             uint  shipsCount   = atoi(tokens.at(4).c_str());
             uint  ownerID    = atoi(tokens.at(3).c_str());
 
-            Player* owner = playerByID(ownerID);
-            if (!owner) {
-                owner = new Player(ownerID);
-                players_m.push_back(owner);
-                playersCount_m++;
-            }
+            Player* owner = addPlayer(ownerID);
             Planet* updatedPlanet = planets_m.at(planetID);
             updatedPlanet->update(owner, shipsCount);
             owner->addPlanet(updatedPlanet);
@@ -327,14 +444,10 @@ void Game::updateState(const std::string& state)
             Planet* sourcePlanet      = planets_m.at(atoi(tokens.at(3).c_str()));
             Planet* destinationPlanet = planets_m.at(atoi(tokens.at(4).c_str()));
 
-            Player* owner = playerByID(ownerID);
-            if (!owner) {
-                owner = new Player(ownerID);
-                players_m.push_back(owner);
-                playersCount_m++;
-            }
+            Player* owner = addPlayer(ownerID);
 
             Fleet* newFleet = new Fleet(owner, sourcePlanet, destinationPlanet, shipsCount, tripLength, turnsRemaining);
+            trackFleet(newFleet);
             fleets_m.push_back(newFleet);
 
             // Add fleet to source and destination planet respectively
@@ -344,21 +457,97 @@ void Game::updateState(const std::string& state)
         }
     }
 
+    for (uint i = 0; i < planetsCount_m; ++i) {
+        planets_m.at(i)->aggregateArrivals();
+    }
+    snapshot_m.update(planets_m);
+
     turn_m++;
 }
 
 void Game::updateState(Order order)
 {
     if (order.isValid()) {
-        // Update number of ships on the source planet
-        order.sourcePlanet->update(order.sourcePlanet->owner(), order.sourcePlanet->shipsCount() - order.shipsCount);
+        updateState(order, new Fleet(order));
+    }
+}
+
+void Game::updateState(const Order& order, Fleet* newFleet)
+{
+    // Update number of ships on the source planet
+    order.sourcePlanet->update(order.sourcePlanet->owner(), order.sourcePlanet->shipsCount() - order.shipsCount);
+
+    newFleet->fleetID_m = nextFleetID_m++;
+    fleets_m.push_back(newFleet);
+
+    // Add fleet to source and destination planet respectively
+    order.sourcePlanet->addLeavingFleet(newFleet);
+    order.destinationPlanet->addIncomingFleet(newFleet);
+    order.destinationPlanet->aggregateArrivals();
+    snapshot_m.addOrder(order.sourcePlanet->planetID(), order.destinationPlanet->planetID(), order.shipsCount);
+}
+
+size_t Game::fleetHash(uint ownerID, uint sourceID, uint destinationID, uint tripLength, uint turnsRemaining, uint shipsCount)
+{
+    // FNV-1a over the fields, good enough for the few hundred fleets in flight
+    uint fields[] = { ownerID, sourceID, destinationID, tripLength, turnsRemaining, shipsCount };
+    size_t hash = 14695981039346656037ULL;
+    for (uint i = 0; i < 6; ++i) {
+        hash ^= fields[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+//stores the fleets currently in flight (including the ones I just sent), so they can be recognised in the next turn
+void Game::rememberFleets()
+{
+    previousFleets_m.clear();
+    uint size = fleets_m.size();
+    for (uint i = 0; i < size; ++i) {
+        Fleet* fleet = fleets_m.at(i);
+        FleetRecord record;
+        record.ownerID        = fleet->owner()->playerID();
+        record.sourceID       = fleet->sourcePlanet()->planetID();
+        record.destinationID  = fleet->destinationPlanet()->planetID();
+        record.tripLength     = fleet->tripLength();
+        record.turnsRemaining = fleet->turnsRemaining();
+        record.shipsCount     = fleet->shipsCount();
+        record.fleetID        = fleet->fleetID();
+        size_t hash = fleetHash(record.ownerID, record.sourceID, record.destinationID, record.tripLength, record.turnsRemaining, record.shipsCount);
+        previousFleets_m.insert(FleetRecords::value_type(hash, record));
+    }
+}
 
-        Fleet* newFleet = new Fleet(order);
-        fleets_m.push_back(newFleet);
+//gives a freshly parsed fleet the ID it had in the previous turn, or a new one if it has just departed
+void Game::trackFleet(Fleet* fleet)
+{
+    uint ownerID        = fleet->owner()->playerID();
+    uint sourceID       = fleet->sourcePlanet()->planetID();
+    uint destinationID  = fleet->destinationPlanet()->planetID();
+    // The fleet has moved one step since we last saw it
+    uint turnsRemaining = fleet->turnsRemaining() + 1;
+    size_t hash = fleetHash(ownerID, sourceID, destinationID, fleet->tripLength(), turnsRemaining, fleet->shipsCount());
+
+    std::pair<FleetRecords::iterator, FleetRecords::iterator> range = previousFleets_m.equal_range(hash);
+    for (FleetRecords::iterator it = range.first; it != range.second; ++it) {
+        const FleetRecord& record = it->second;
+        if (record.ownerID == ownerID
+            && record.sourceID == sourceID
+            && record.destinationID == destinationID
+            && record.tripLength == fleet->tripLength()
+            && record.turnsRemaining == turnsRemaining
+            && record.shipsCount == fleet->shipsCount()) {
+            fleet->fleetID_m = record.fleetID;
+            // Identical fleets are matched one by one
+            previousFleets_m.erase(it);
+            return;
+        }
+    }
 
-        // Add fleet to source and destination planet respectively
-        order.sourcePlanet->addLeavingFleet(newFleet);
-        order.destinationPlanet->addIncomingFleet(newFleet);
+    fleet->fleetID_m = nextFleetID_m++;
+    if (fleet->owner()->isEnemy()) {
+        newEnemyFleets_m.push_back(fleet);
     }
 }
 
@@ -367,3 +556,201 @@ void Game::finishTurn() const {
     std::cout.flush();
 }
 
+Game::Hops const& Game::hops(uint planetID) const
+{
+    return hops_m[planetID];
+}
+
+Game::Hops const& Game::dominatedHops(uint planetID) const
+{
+    return dominatedHops_m[planetID];
+}
+
+float Game::hopCost(uint planetID1, uint planetID2) const
+{
+    return hopCosts_m[planetID1 * planetsCount_m + planetID2];
+}
+
+// The supply routes only depend on the positions of the planets, apart from which planets ships may be sent over.
+// A step from a to b is dominated if there is a planet c with cost(a,c) + cost(c,b) < cost(a,b). As long as ships
+// may be sent over c, no cheapest route takes the step, so it has to be looked at only if c can't be used.
+// Since c is strictly cheaper, the steps to and from c are again either not dominated or have a cheaper way.
+void Game::computeHops()
+{
+    uint n = planetsCount_m;
+    std::vector<uint> hopsBegin;
+    std::vector<uint> dominatedHopsBegin;
+    std::vector<Hop> allHops;
+    std::vector<Hop> allDominatedHops;
+    if (mapCache_m.get(MapCache::HopCosts, hopCosts_m) && hopCosts_m.size() == n * n
+        && mapCache_m.get(MapCache::HopsBegin, hopsBegin) && hopsBegin.size() == n + 1
+        && mapCache_m.get(MapCache::DominatedHopsBegin, dominatedHopsBegin) && dominatedHopsBegin.size() == n + 1) {
+        mapCache_m.get(MapCache::Hops, allHops);
+        mapCache_m.get(MapCache::DominatedHops, allDominatedHops);
+        if (allHops.size() == hopsBegin[n] && allDominatedHops.size() == dominatedHopsBegin[n]) {
+            hops_m.resize(n);
+            dominatedHops_m.resize(n);
+            for (uint i = 0; i < n; ++i) {
+                hops_m[i].assign(allHops.begin() + hopsBegin[i], allHops.begin() + hopsBegin[i + 1]);
+                dominatedHops_m[i].assign(allDominatedHops.begin() + dominatedHopsBegin[i], allDominatedHops.begin() + dominatedHopsBegin[i + 1]);
+            }
+            return;
+        }
+    }
+
+    hopCosts_m.resize(n * n);
+    for (uint i = 0; i < n; ++i) {
+        for (uint j = 0; j < n; ++j) {
+            hopCosts_m[i * n + j] = i == j ? 0 : planets_m[i]->GetCost(*planets_m[j]);
+        }
+    }
+
+    // The costs only depend on the distances, so on a symmetric map the witnesses of one half of the rows are
+    // mirrored onto the other half. If several witnesses are equally cheap, the mirror may pick another one.
+    std::vector<int> witnesses(n * n, -1);
+    for (uint i = 0; i < n; ++i) {
+        if (mirrors_m[i] < int(i)) {
+            continue;
+        }
+        for (uint j = 0; j < n; ++j) {
+            float cheapest = hopCost(i, j);
+            for (uint k = 0; k < n; ++k) {
+                float cost = hopCost(i, k) + hopCost(k, j);
+                if (k != i && k != j && cost < cheapest) {
+                    cheapest = cost;
+                    witnesses[i * n + j] = k;
+                }
+            }
+        }
+    }
+    for (uint i = 0; i < n; ++i) {
+        if (mirrors_m[i] < int(i)) {
+            for (uint j = 0; j < n; ++j) {
+                int witness = witnesses[mirrors_m[i] * n + mirrors_m[j]];
+                witnesses[i * n + j] = witness < 0 ? -1 : mirrors_m[witness];
+            }
+        }
+    }
+
+    hops_m.assign(n, Hops());
+    dominatedHops_m.assign(n, Hops());
+    for (uint i = 0; i < n; ++i) {
+        const Planets& closest = planets_m[i]->closestPlanets_m;
+        for (Planets::const_iterator pit = closest.begin(); pit != closest.end(); ++pit) {
+            uint j = (*pit)->planetID();
+            Hop hop = { j, hopCost(i, j), witnesses[i * n + j] };
+            if (hop.witness < 0) {
+                hops_m[i].push_back(hop);
+            } else {
+                dominatedHops_m[i].push_back(hop);
+            }
+        }
+    }
+
+    for (uint i = 0; i < n; ++i) {
+        hopsBegin.push_back(allHops.size());
+        allHops.insert(allHops.end(), hops_m[i].begin(), hops_m[i].end());
+        dominatedHopsBegin.push_back(allDominatedHops.size());
+        allDominatedHops.insert(allDominatedHops.end(), dominatedHops_m[i].begin(), dominatedHops_m[i].end());
+    }
+    hopsBegin.push_back(allHops.size());
+    dominatedHopsBegin.push_back(allDominatedHops.size());
+    mapCache_m.put(MapCache::HopCosts, hopCosts_m);
+    mapCache_m.put(MapCache::HopsBegin, hopsBegin);
+    mapCache_m.put(MapCache::Hops, allHops);
+    mapCache_m.put(MapCache::DominatedHopsBegin, dominatedHopsBegin);
+    mapCache_m.put(MapCache::DominatedHops, allDominatedHops);
+}
+
+MapCache& Game::mapCache()
+{
+    return mapCache_m;
+}
+
+Game::Timings const& Game::mapAnalysisTimes() const
+{
+    return mapAnalysisTimes_m;
+}
+
+double Game::now()
+{
+    timeval tim;
+    gettimeofday(&tim, NULL);
+    return tim.tv_sec + (tim.tv_usec / 1000000.0);
+}
+
+void Game::addMapAnalysisTime(const std::string& name, double& start)
+{
+    double end = now();
+    mapAnalysisTimes_m.push_back(std::make_pair(name, end - start));
+    start = end;
+}
+
+bool Game::symmetric() const
+{
+    return symmetric_m;
+}
+
+uint Game::mirror(uint planetID) const
+{
+    return mirrors_m[planetID];
+}
+
+std::vector<int> const& Game::mirrors() const
+{
+    return mirrors_m;
+}
+
+// The center of a point symmetric map is the mean of all planet positions. The mirror of a planet has to be
+// at the mirrored position and have the same growth rate. On top of that, all distances have to be the same
+// after mirroring, so tables computed from the distances can be mirrored exactly.
+void Game::detectSymmetry()
+{
+    uint n = planetsCount_m;
+    mirrors_m.resize(n);
+    for (uint i = 0; i < n; ++i) {
+        mirrors_m[i] = i;
+    }
+    symmetric_m = false;
+    if (n == 0) {
+        return;
+    }
+
+    double centerX = 0;
+    double centerY = 0;
+    for (uint i = 0; i < n; ++i) {
+        centerX += planets_m[i]->coordinate().x();
+        centerY += planets_m[i]->coordinate().y();
+    }
+    centerX /= n;
+    centerY /= n;
+
+    const double tolerance = 1e-4;
+    std::vector<int> mirrors(n, -1);
+    for (uint i = 0; i < n; ++i) {
+        double x = 2 * centerX - planets_m[i]->coordinate().x();
+        double y = 2 * centerY - planets_m[i]->coordinate().y();
+        for (uint j = 0; j < n; ++j) {
+            if (std::fabs(planets_m[j]->coordinate().x() - x) < tolerance && std::fabs(planets_m[j]->coordinate().y() - y) < tolerance
+                && planets_m[j]->growthRate() == planets_m[i]->growthRate()) {
+                mirrors[i] = j;
+                break;
+            }
+        }
+        if (mirrors[i] < 0) {
+            return;
+        }
+    }
+    for (uint i = 0; i < n; ++i) {
+        if (uint(mirrors[mirrors[i]]) != i) {
+            return;
+        }
+        for (uint j = 0; j < n; ++j) {
+            if (snapshot_m.distance(i, j) != snapshot_m.distance(mirrors[i], mirrors[j])) {
+                return;
+            }
+        }
+    }
+    mirrors_m = mirrors;
+    symmetric_m = true;
+}
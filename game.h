@@ -2,8 +2,11 @@
 #define GAMESTATE_H
 
 #include <string>
+#include <unordered_map>
 
 #include "defines.h"
+#include "snapshot.h"
+#include "mapcache.h"
 
 class Game {
 public:
@@ -18,6 +21,8 @@ public:
 
     uint turn() const;
 
+    // The players including the neutral one, with the IDs 0 to playersCount() - 1. Up to 8 players besides the neutral one are supported.
+    uint playersCount() const;
     const Player* playerByID(uint playerID) const;
     Player* playerByID(uint playerID);
 
@@ -31,16 +36,86 @@ public:
     Planets enemyPlanets() const;
     Planets notMyPlanets() const;
 
+    const Fleet* fleetByID(uint fleetID) const;
+    Fleet* fleetByID(uint fleetID);
+
     Fleets const& fleets() const;
     Fleets myFleets() const;
     Fleets enemyFleets() const;
+    // Enemy fleets that were not in flight in the previous turn, i.e. the orders the enemy issued last turn.
+    Fleets const& newEnemyFleets() const;
+
+    // Flat copy of the current state for the simulations, kept up to date with the issued orders.
+    const Snapshot& snapshot() const;
+
+    // A step of the supply chain, with the cost of Planet::GetCost().
+    // A step is dominated if going over the witness planet is cheaper. It is only needed when
+    // ships can't be sent over the witness.
+    struct Hop {
+        uint planetID;
+        float cost;
+        int witness;
+    };
+    typedef std::vector<Hop> Hops;
+
+    // The steps from the planet that are not dominated, computed once per map. Costs are symmetric,
+    // so these are also the steps to the planet.
+    Hops const& hops(uint planetID) const;
+    Hops const& dominatedHops(uint planetID) const;
+    float hopCost(uint planetID1, uint planetID2) const;
+
+    // Standard maps are point symmetric, with the starting planets mirrored onto each other.
+    // mirror() is the planet at the mirrored position, which has the same growth rate and the same distances
+    // to the mirrored planets. If the map is not symmetric, every planet is its own mirror.
+    bool symmetric() const;
+    uint mirror(uint planetID) const;
+    std::vector<int> const& mirrors() const;
+
+    // Static tables of the map that are kept between games. The bot adds its own tables and saves it.
+    MapCache& mapCache();
+
+    // How long the steps of the static analysis in initializeState() took, in seconds.
+    typedef std::vector<std::pair<std::string, double> > Timings;
+    Timings const& mapAnalysisTimes() const;
 
     void issueOrder(const Order& order);
 
+    // Orders for a search: applyOrder() changes the planets, fleets and the snapshot like issueOrder(), but doesn't send
+    // the order, and undoOrders() takes the applied orders back, the last one first. Nothing is copied, and the fleets
+    // of undone orders are reused. No order may be issued while applied orders are outstanding.
+    void applyOrder(const Order& order);
+    // The number of applied orders that were not undone yet, to undo back to later
+    uint appliedOrdersCount() const;
+    void undoOrders(uint appliedOrdersCount);
+
     void finishTurn() const;
 
 private:
+    // What is known about a fleet from the game state, used to recognise the same fleet in the next turn.
+    struct FleetRecord {
+        uint ownerID;
+        uint sourceID;
+        uint destinationID;
+        uint tripLength;
+        uint turnsRemaining;
+        uint shipsCount;
+        uint fleetID;
+    };
+    typedef std::unordered_multimap<size_t, FleetRecord> FleetRecords;
+
+    static size_t fleetHash(uint ownerID, uint sourceID, uint destinationID, uint tripLength, uint turnsRemaining, uint shipsCount);
+    void rememberFleets();
+    void trackFleet(Fleet* fleet);
+
+    // The simulations keep the players in arrays of MaxPlayersCount, so larger IDs throw std::out_of_range,
+    // like planet IDs that don't exist.
+    Player* addPlayer(uint playerID);
     void updateState(Order order);
+    void updateState(const Order& order, Fleet* newFleet);
+    void computeHops();
+    void detectSymmetry();
+    static double now();
+    void addMapAnalysisTime(const std::string& name, double& start);
     void deleteFleets();
     void deletePlanets();
     void deletePlayers();
@@ -54,11 +129,30 @@ private:
     uint turn_m;
     uint planetsCount_m;
     uint playersCount_m;
+    uint nextFleetID_m;
 
     // Store all the planets and fleets.
     Planets planets_m;
     Fleets  fleets_m;
     std::vector<Player*> players_m;
+    Snapshot snapshot_m;
+    // The fleets of the applied orders, the last applied order last, and the fleets of undone orders for reuse
+    Fleets appliedFleets_m;
+    Fleets spareFleets_m;
+    MapCache mapCache_m;
+    Timings mapAnalysisTimes_m;
+
+    // The supply steps, indexed by planet ID
+    std::vector<Hops> hops_m;
+    std::vector<Hops> dominatedHops_m;
+    std::vector<float> hopCosts_m;
+
+    bool symmetric_m;
+    std::vector<int> mirrors_m;
+
+    // Fleets of the previous turn, hashed by everything the engine tells us about them.
+    FleetRecords previousFleets_m;
+    Fleets newEnemyFleets_m;
 };
 
 #endif // GAMESTATE_H
@@ -0,0 +1,165 @@
+#include "gamestate.h"
+
+#include <algorithm>
+
+GameState::GameState() :
+    distances_m(0),
+    planetsCount_m(0),
+    playersCount_m(MaxPlayers),
+    fleetsCount_m(0),
+    turn_m(0)
+{
+}
+
+bool GameState::set(const Snapshot& snapshot, int turn)
+{
+    int planetsCount = snapshot.planetsCount();
+    int fleetsCount = snapshot.fleetOwner.size();
+    if (planetsCount > MaxPlanets || snapshot.playersCount() > MaxPlayers || fleetsCount > MaxFleets) {
+        return false;
+    }
+    distances_m = &snapshot.distances()[0];
+    planetsCount_m = planetsCount;
+    playersCount_m = snapshot.playersCount();
+    turn_m = turn;
+    for (int p = 0; p < planetsCount; ++p) {
+        planetOwner_m[p] = snapshot.planetOwner[p];
+        planetShips_m[p] = snapshot.planetShips[p];
+        planetGrowth_m[p] = snapshot.planetGrowth[p];
+    }
+    fleetsCount_m = 0;
+    for (int f = 0; f < fleetsCount; ++f) {
+        addFleet(snapshot.fleetOwner[f], snapshot.fleetDestination[f], snapshot.fleetArrival[f], snapshot.fleetShips[f]);
+    }
+    return true;
+}
+
+bool GameState::addFleet(int owner, int destination, int turnsRemaining, int shipsCount)
+{
+    if (fleetsCount_m == MaxFleets) {
+        //fleets with the same owner, destination and arrival fight together, so they can be merged
+        for (int f = 0; f < fleetsCount_m; ++f) {
+            Fleet& fleet = fleets_m[f];
+            if (fleet.owner == owner && fleet.destination == destination && fleet.turnsRemaining == turnsRemaining) {
+                fleet.shipsCount += shipsCount;
+                return true;
+            }
+        }
+        return false;
+    }
+    Fleet& fleet = fleets_m[fleetsCount_m++];
+    fleet.owner = owner;
+    fleet.destination = destination;
+    fleet.turnsRemaining = turnsRemaining;
+    fleet.shipsCount = shipsCount;
+    return true;
+}
+
+bool GameState::step(const Move* moves, int movesCount)
+{
+    bool allMoves = true;
+    for (int i = 0; i < movesCount; ++i) {
+        const Move& move = moves[i];
+        int owner = planetOwner_m[move.source];
+        if (owner == NeutralID || move.source == move.destination || move.shipsCount <= 0 || move.shipsCount > planetShips_m[move.source]) {
+            continue;
+        }
+        //the ships only leave the planet if there is a fleet for them
+        if (addFleet(owner, move.destination, distance(move.source, move.destination), move.shipsCount)) {
+            planetShips_m[move.source] -= move.shipsCount;
+        } else {
+            allMoves = false;
+        }
+    }
+
+    for (int p = 0; p < planetsCount_m; ++p) {
+        if (planetOwner_m[p] != NeutralID) {
+            planetShips_m[p] += planetGrowth_m[p];
+        }
+    }
+
+    //the forces of each player at each planet, for the planets with arrivals, playersCount_m entries per planet
+    int participants[MaxPlanets * MaxPlayers];
+    const int players = playersCount_m;
+    bool battle[MaxPlanets];
+    std::fill(battle, battle + planetsCount_m, false);
+    for (int f = 0; f < fleetsCount_m; ) {
+        Fleet& fleet = fleets_m[f];
+        if (--fleet.turnsRemaining > 0) {
+            ++f;
+            continue;
+        }
+        int p = fleet.destination;
+        if (!battle[p]) {
+            battle[p] = true;
+            std::fill(participants + p * players, participants + (p + 1) * players, 0);
+            participants[p * players + planetOwner_m[p]] = planetShips_m[p];
+        }
+        participants[p * players + fleet.owner] += fleet.shipsCount;
+        fleet = fleets_m[--fleetsCount_m];
+    }
+    for (int p = 0; p < planetsCount_m; ++p) {
+        if (battle[p]) {
+            int owner = planetOwner_m[p];
+            resolveBattle(participants + p * players, players, owner, planetShips_m[p]);
+            planetOwner_m[p] = owner;
+        }
+    }
+    ++turn_m;
+    return allMoves;
+}
+
+int GameState::playerShipsCount(int player) const
+{
+    int shipsCount = 0;
+    for (int p = 0; p < planetsCount_m; ++p) {
+        if (planetOwner_m[p] == player) {
+            shipsCount += planetShips_m[p];
+        }
+    }
+    for (int f = 0; f < fleetsCount_m; ++f) {
+        if (fleets_m[f].owner == player) {
+            shipsCount += fleets_m[f].shipsCount;
+        }
+    }
+    return shipsCount;
+}
+
+int GameState::playerGrowthRate(int player) const
+{
+    int growthRate = 0;
+    for (int p = 0; p < planetsCount_m; ++p) {
+        if (planetOwner_m[p] == player) {
+            growthRate += planetGrowth_m[p];
+        }
+    }
+    return growthRate;
+}
+
+bool GameState::isAlive(int player) const
+{
+    for (int p = 0; p < planetsCount_m; ++p) {
+        if (planetOwner_m[p] == player) {
+            return true;
+        }
+    }
+    for (int f = 0; f < fleetsCount_m; ++f) {
+        if (fleets_m[f].owner == player) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int GameState::winner() const
+{
+    int alive = 0;
+    int winner = 0;
+    for (int player = MyID; player < playersCount_m; ++player) {
+        if (isAlive(player)) {
+            ++alive;
+            winner = player;
+        }
+    }
+    return alive > 1 ? -1 : winner;
+}
@@ -0,0 +1,81 @@
+#ifndef GAME_STATE_H
+#define GAME_STATE_H
+
+#include "snapshot.h"
+
+// The whole game in fixed-size arrays, advanced one turn at a time with the orders of all players.
+// Unlike the planet simulations of Snapshot, fleets move between planets and all battles of a turn
+// happen together, so this is the model of the game the searches play on.
+// The state has no pointers to owned memory: a copy is a single memcpy and no step allocates.
+// The distances are shared with the snapshot the state was set from.
+class GameState {
+public:
+    enum {
+        MaxPlanets = 256,
+        MaxPlayers = MaxPlayersCount,
+        MaxFleets = 1024
+    };
+
+    // An order of the owner of the source planet
+    struct Move {
+        int source;
+        int destination;
+        int shipsCount;
+    };
+
+    struct Fleet {
+        unsigned char owner;
+        unsigned char turnsRemaining;
+        unsigned short destination;
+        int shipsCount;
+    };
+
+    GameState();
+
+    // Copies the planets and fleets in flight. Returns false if the snapshot does not fit into the state.
+    bool set(const Snapshot& snapshot, int turn);
+
+    // One turn of the game: the moves of all players depart, the planets grow, the fleets move, and the
+    // battles are fought. Moves for planets of other players or with more ships than the planet has are ignored.
+    // At most MaxFleets fleets can be in flight. A move that would need another fleet when all are in use, and that
+    // can't be merged into a fleet with the same owner, destination and arrival, is ignored too.
+    // Returns false if any move was ignored because of that.
+    bool step(const Move* moves, int movesCount);
+
+    int turn() const { return turn_m; }
+    int planetsCount() const { return planetsCount_m; }
+    int playersCount() const { return playersCount_m; }
+    int distance(int planet1, int planet2) const { return distances_m[planet1 * planetsCount_m + planet2]; }
+
+    int owner(int planet) const { return planetOwner_m[planet]; }
+    int shipsCount(int planet) const { return planetShips_m[planet]; }
+    int growthRate(int planet) const { return planetGrowth_m[planet]; }
+
+    int fleetsCount() const { return fleetsCount_m; }
+    const Fleet& fleet(int i) const { return fleets_m[i]; }
+
+    // Ships on planets and in flight, and the growth rate of the planets of a player
+    int playerShipsCount(int player) const;
+    int playerGrowthRate(int player) const;
+    // A player is alive as long as he has planets or fleets
+    bool isAlive(int player) const;
+    // The only player left alive, 0 if all are dead and -1 if the game is not over
+    int winner() const;
+
+private:
+    // Returns false if all fleets are in use and none can take the ships
+    bool addFleet(int owner, int destination, int turnsRemaining, int shipsCount);
+
+    const int* distances_m;
+    int planetsCount_m;
+    int playersCount_m;
+    int fleetsCount_m;
+    int turn_m;
+
+    unsigned char planetOwner_m[MaxPlanets];
+    int planetShips_m[MaxPlanets];
+    int planetGrowth_m[MaxPlanets];
+    Fleet fleets_m[MaxFleets];
+};
+
+#endif // GAME_STATE_H
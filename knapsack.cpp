@@ -0,0 +1,39 @@
+#include "knapsack.h"
+
+void Knapsack::solve(const std::vector<KnapsackTarget>& candidates, int maxWeight, std::vector<KnapsackTarget>& chosen)
+{
+    chosen.clear();
+    if (maxWeight <= 0) {
+        return;
+    }
+    int n = candidates.size();
+    int width = maxWeight + 1;
+    values_m.assign(width, 0);
+    improved_m.assign((long(n) * width + 63) / 64, 0);
+
+    for (int k = 0; k < n; ++k) {
+        int weight = candidates[k].weight;
+        int value = candidates[k].value;
+        if (weight < 0) {
+            continue;
+        }
+        //going down, so values_m[w - weight] is still the entry without candidate k
+        long row = long(k) * width;
+        for (int w = maxWeight; w >= weight; --w) {
+            int newValue = values_m[w - weight] + value;
+            if (newValue > values_m[w]) {
+                values_m[w] = newValue;
+                improved_m[(row + w) >> 6] |= 1ULL << ((row + w) & 63);
+            }
+        }
+    }
+
+    int w = maxWeight;
+    for (int k = n - 1; k >= 0 && w > 0; --k) {
+        long bit = long(k) * width + w;
+        if ((improved_m[bit >> 6] >> (bit & 63)) & 1) {
+            chosen.push_back(candidates[k]);
+            w -= candidates[k].weight;
+        }
+    }
+}
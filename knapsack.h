@@ -0,0 +1,25 @@
+#ifndef KNAPSACK_H
+#define KNAPSACK_H
+
+#include <vector>
+
+#include "knapsackTarget.h"
+
+// Allocates a number of ships to targets by solving the knapsack01-problem with dynamic programming.
+// Only one row of the table is kept, indexed by the number of ships. For the reconstruction it is enough
+// to know which target improved which entry, this is kept as one bit per target and number of ships.
+// The buffers are kept between calls, so the solver can be used several times per turn.
+class Knapsack {
+public:
+    // Chooses the targets with the highest total value whose total weight is at most maxWeight.
+    // The chosen targets are in reverse order of the candidates. Targets with a negative weight are never chosen.
+    void solve(const std::vector<KnapsackTarget>& candidates, int maxWeight, std::vector<KnapsackTarget>& chosen);
+
+private:
+    // best total value with at most w ships, for the candidates so far
+    std::vector<int> values_m;
+    // bit k*(maxWeight+1)+w is set if candidate k improved the best value with at most w ships
+    std::vector<unsigned long long> improved_m;
+};
+
+#endif // KNAPSACK_H
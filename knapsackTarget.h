@@ -4,7 +4,7 @@
 #include "planet.h"
 
 struct KnapsackTarget{
-  Planet p;
+  Planet* p;
   int t;
   int weight;
   int value;
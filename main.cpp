@@ -3,6 +3,7 @@
 
 #include <sys/time.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <iostream>
 
 using std::cerr;
@@ -11,7 +12,35 @@ using std::endl;
 // This is just the main game loop that takes care of communicating with the game engine for you.
 int main() {
     Game game;
+    //static tables of maps that were played before are kept here
+    const char* mapCache = getenv("PLANETWARS_MAP_CACHE");
+    game.mapCache().setDirectory(mapCache ? mapCache : "/tmp");
     MyBot myBot(&game);
+    //number of worker threads for the rollout evaluation, which is off if this is not set
+    const char* rolloutThreads = getenv("PLANETWARS_ROLLOUT_THREADS");
+    if (rolloutThreads) {
+        myBot.enableRollouts(atoi(rolloutThreads));
+    }
+    //"maximin" or "mixed" turns on the matrix game against the enemy's responses, other values are ignored
+    const char* matrixGame = getenv("PLANETWARS_MATRIX_GAME");
+    if (matrixGame && (std::string(matrixGame) == "maximin" || std::string(matrixGame) == "mixed")) {
+        myBot.enableMatrixGame(std::string(matrixGame) == "mixed");
+    }
+    //remaining turns below which the endgame search takes over, 0 turns it off
+    const char* endgameTurns = getenv("PLANETWARS_ENDGAME_TURNS");
+    if (endgameTurns) {
+        myBot.setEndgameTurns(atoi(endgameTurns));
+    }
+    //number of action sets kept by the beam search, 1 or less keeps the greedy choice of actions
+    const char* beamWidth = getenv("PLANETWARS_BEAM_WIDTH");
+    if (beamWidth) {
+        myBot.setBeamWidth(atoi(beamWidth));
+    }
+    //time limit of the first turn in seconds, which bounds the optional steps of the analysis of the map
+    const char* firstTurnTime = getenv("PLANETWARS_FIRST_TURN_TIME");
+    if (firstTurnTime) {
+        myBot.setFirstTurnMaxTime(atof(firstTurnTime));
+    }
     std::string currentLine;
     std::string mapData;
     while (true) {
@@ -0,0 +1,171 @@
+#include "mapcache.h"
+
+#include <cstdio>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "planet.h"
+#include "point2d.h"
+
+// "PWMC"
+static const unsigned int cacheMagic = 0x434d5750;
+// Has to be increased whenever a table changes its meaning or layout
+static const unsigned int cacheVersion = 1;
+
+MapCache::MapCache() :
+    fingerprint_m(0),
+    modified_m(false),
+    mapping_m(0),
+    mappingSize_m(0)
+{
+}
+
+MapCache::~MapCache()
+{
+    unmap();
+}
+
+//FNV-1a over the number of planets, their coordinates and growth rates
+unsigned long long MapCache::fingerprint(const Planets& planets)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    std::vector<double> values;
+    values.push_back(planets.size());
+    for (Planets::const_iterator pit = planets.begin(); pit != planets.end(); ++pit) {
+        values.push_back((*pit)->coordinate().x());
+        values.push_back((*pit)->coordinate().y());
+        values.push_back((*pit)->growthRate());
+    }
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&values[0]);
+    for (size_t i = 0; i < values.size() * sizeof(double); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+void MapCache::setDirectory(const std::string& directory)
+{
+    directory_m = directory;
+}
+
+std::string MapCache::path() const
+{
+    std::ostringstream path;
+    path << directory_m << "/planetwars-" << std::hex << fingerprint_m << ".map";
+    return path.str();
+}
+
+bool MapCache::load(unsigned long long fingerprint)
+{
+    unmap();
+    fingerprint_m = fingerprint;
+    modified_m = false;
+    for (int i = 0; i < SectionsCount; ++i) {
+        put_m[i].clear();
+    }
+    if (directory_m.empty()) {
+        return false;
+    }
+
+    int fd = open(path().c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+    void* mapping = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    const Header* header = static_cast<const Header*>(mapping);
+    bool valid = header->magic == cacheMagic && header->version == cacheVersion && header->fingerprint == fingerprint
+        && header->offsets[0] == sizeof(Header) && header->offsets[SectionsCount] == size_t(st.st_size);
+    for (int i = 0; valid && i < SectionsCount; ++i) {
+        valid = header->offsets[i] <= header->offsets[i + 1];
+    }
+    if (!valid) {
+        munmap(mapping, st.st_size);
+        return false;
+    }
+    mapping_m = mapping;
+    mappingSize_m = st.st_size;
+    return true;
+}
+
+bool MapCache::loaded() const
+{
+    return mapping_m != 0;
+}
+
+void MapCache::unmap()
+{
+    if (mapping_m) {
+        munmap(mapping_m, mappingSize_m);
+        mapping_m = 0;
+        mappingSize_m = 0;
+    }
+}
+
+//tables that were put take precedence over the file, empty tables count as missing
+const char* MapCache::section(Section section, size_t& size) const
+{
+    if (!put_m[section].empty()) {
+        size = put_m[section].size();
+        return &put_m[section][0];
+    }
+    if (mapping_m) {
+        const Header* header = static_cast<const Header*>(mapping_m);
+        size = header->offsets[section + 1] - header->offsets[section];
+        if (size > 0) {
+            return static_cast<const char*>(mapping_m) + header->offsets[section];
+        }
+    }
+    size = 0;
+    return 0;
+}
+
+bool MapCache::save()
+{
+    if (!modified_m || directory_m.empty()) {
+        return false;
+    }
+    Header header;
+    header.magic = cacheMagic;
+    header.version = cacheVersion;
+    header.fingerprint = fingerprint_m;
+    header.offsets[0] = sizeof(Header);
+    for (int i = 0; i < SectionsCount; ++i) {
+        size_t size;
+        section(Section(i), size);
+        header.offsets[i + 1] = header.offsets[i] + size;
+    }
+
+    //write a temporary file and rename it, so no other bot ever sees half a file
+    std::ostringstream temporary;
+    temporary << path() << "." << getpid();
+    FILE* file = fopen(temporary.str().c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(Header), 1, file) == 1;
+    for (int i = 0; ok && i < SectionsCount; ++i) {
+        size_t size;
+        const char* data = section(Section(i), size);
+        ok = size == 0 || fwrite(data, size, 1, file) == 1;
+    }
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temporary.str().c_str(), path().c_str()) != 0) {
+        unlink(temporary.str().c_str());
+        return false;
+    }
+    modified_m = false;
+    return true;
+}
@@ -0,0 +1,93 @@
+#ifndef MAPCACHE_H
+#define MAPCACHE_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "defines.h"
+
+// Static analysis of a map, kept on disk between games.
+// The file of a map is named after a fingerprint of the planet coordinates and growth rates, and holds
+// one section per table. It is mapped into memory, so loading costs next to nothing. Tables that are
+// missing are computed as usual and put into the cache, which then writes the file again.
+class MapCache {
+public:
+    enum Section {
+        Distances,
+        ClosestPlanets,
+        HopCosts,
+        HopsBegin,
+        Hops,
+        DominatedHopsBegin,
+        DominatedHops,
+        Protectors,
+        Threats,
+        ClosenessRanks,
+        Between,
+        Coverers,
+        ClosestPrefixes,
+        SectionsCount
+    };
+
+    MapCache();
+    ~MapCache();
+
+    static unsigned long long fingerprint(const Planets& planets);
+
+    // An empty directory disables the cache.
+    void setDirectory(const std::string& directory);
+    // Maps the file of the map. Returns false if there is none, or if it is stale or broken.
+    bool load(unsigned long long fingerprint);
+    bool loaded() const;
+
+    // Copies a table out of the cache, returns false if the cache doesn't have it.
+    template <class T> bool get(Section section, std::vector<T>& values) const;
+    template <class T> void put(Section section, const std::vector<T>& values);
+    // Writes the file again if tables were put since it was loaded.
+    bool save();
+
+private:
+    struct Header {
+        unsigned int magic;
+        unsigned int version;
+        unsigned long long fingerprint;
+        // Sections are stored one after the other, section i takes the bytes [offsets[i], offsets[i+1]).
+        unsigned long long offsets[SectionsCount + 1];
+    };
+
+    const char* section(Section section, size_t& size) const;
+    std::string path() const;
+    void unmap();
+
+    std::string directory_m;
+    unsigned long long fingerprint_m;
+    bool modified_m;
+
+    void* mapping_m;
+    size_t mappingSize_m;
+    // Tables put since loading
+    std::vector<char> put_m[SectionsCount];
+};
+
+
+template <class T> bool MapCache::get(Section section, std::vector<T>& values) const
+{
+    size_t size;
+    const char* data = this->section(section, size);
+    if (!data || size % sizeof(T) != 0) {
+        return false;
+    }
+    values.resize(size / sizeof(T));
+    memcpy(&values[0], data, size);
+    return true;
+}
+
+template <class T> void MapCache::put(Section section, const std::vector<T>& values)
+{
+    const char* data = reinterpret_cast<const char*>(values.empty() ? 0 : &values[0]);
+    put_m[section].assign(data, data + values.size() * sizeof(T));
+    modified_m = true;
+}
+
+#endif // MAPCACHE_H
@@ -0,0 +1,104 @@
+#include "matrixgame.h"
+
+void MatrixGame::reset(int rowsCount, int columnsCount)
+{
+    rowsCount_m = rowsCount;
+    columnsCount_m = columnsCount;
+    payoffs_m.assign(rowsCount * columnsCount, 0);
+    set_m.assign(rowsCount * columnsCount, false);
+}
+
+void MatrixGame::set(int row, int column, double payoff)
+{
+    payoffs_m[row * columnsCount_m + column] = payoff;
+    set_m[row * columnsCount_m + column] = true;
+}
+
+bool MatrixGame::isSet(int row, int column) const
+{
+    return set_m[row * columnsCount_m + column];
+}
+
+double MatrixGame::payoff(int row, int column) const
+{
+    return payoffs_m[row * columnsCount_m + column];
+}
+
+void MatrixGame::completeColumns(std::vector<int>& columns) const
+{
+    columns.clear();
+    for (int c = 0; c < columnsCount_m; ++c) {
+        bool complete = true;
+        for (int r = 0; r < rowsCount_m && complete; ++r) {
+            complete = isSet(r, c);
+        }
+        if (complete) {
+            columns.push_back(c);
+        }
+    }
+}
+
+int MatrixGame::maximinRow() const
+{
+    std::vector<int> columns;
+    completeColumns(columns);
+    if (columns.empty()) {
+        return -1;
+    }
+    int best = -1;
+    double bestWorst = 0;
+    for (int r = 0; r < rowsCount_m; ++r) {
+        double worst = payoff(r, columns[0]);
+        for (std::vector<int>::const_iterator c = columns.begin(); c != columns.end(); ++c) {
+            if (payoff(r, *c) < worst) {
+                worst = payoff(r, *c);
+            }
+        }
+        if (best < 0 || worst > bestWorst) {
+            best = r;
+            bestWorst = worst;
+        }
+    }
+    return best;
+}
+
+void MatrixGame::mixedStrategy(int iterations, std::vector<double>& rowWeights) const
+{
+    std::vector<int> columns;
+    completeColumns(columns);
+    rowWeights.clear();
+    if (columns.empty()) {
+        return;
+    }
+    int columnsCount = columns.size();
+    //the summed payoffs of each row against the columns played so far, and of each column against the rows played so far
+    std::vector<double> rowTotals(rowsCount_m, 0);
+    std::vector<double> columnTotals(columnsCount, 0);
+    std::vector<int> rowCounts(rowsCount_m, 0);
+    int row = 0;
+    for (int i = 0; i < iterations; ++i) {
+        ++rowCounts[row];
+        for (int c = 0; c < columnsCount; ++c) {
+            columnTotals[c] += payoff(row, columns[c]);
+        }
+        int column = 0;
+        for (int c = 1; c < columnsCount; ++c) {
+            if (columnTotals[c] < columnTotals[column]) {
+                column = c;
+            }
+        }
+        for (int r = 0; r < rowsCount_m; ++r) {
+            rowTotals[r] += payoff(r, columns[column]);
+        }
+        row = 0;
+        for (int r = 1; r < rowsCount_m; ++r) {
+            if (rowTotals[r] > rowTotals[row]) {
+                row = r;
+            }
+        }
+    }
+    rowWeights.resize(rowsCount_m);
+    for (int r = 0; r < rowsCount_m; ++r) {
+        rowWeights[r] = double(rowCounts[r]) / iterations;
+    }
+}
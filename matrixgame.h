@@ -0,0 +1,35 @@
+#ifndef MATRIXGAME_H
+#define MATRIXGAME_H
+
+#include <vector>
+
+// A zero-sum game with simultaneous moves, given by the payoffs of the row player.
+// The matrix may be filled partially, e.g. when there was no time for all payoffs.
+// The strategies only use the columns that are filled for every row.
+class MatrixGame {
+public:
+    void reset(int rowsCount, int columnsCount);
+    int rowsCount() const { return rowsCount_m; }
+    int columnsCount() const { return columnsCount_m; }
+
+    void set(int row, int column, double payoff);
+    bool isSet(int row, int column) const;
+    double payoff(int row, int column) const;
+
+    // The row with the best worst case over the complete columns, or -1 if no column is complete.
+    int maximinRow() const;
+    // The mixed strategy of the row player, approximated by fictitious play: both players play the best response
+    // to the moves of the other player so far, and the frequencies of the rows converge to an optimal strategy.
+    // The weights are empty if no column is complete.
+    void mixedStrategy(int iterations, std::vector<double>& rowWeights) const;
+
+private:
+    void completeColumns(std::vector<int>& columns) const;
+
+    int rowsCount_m;
+    int columnsCount_m;
+    std::vector<double> payoffs_m;
+    std::vector<bool> set_m;
+};
+
+#endif // MATRIXGAME_H
@@ -1,6 +1,5 @@
 #include "planet.h"
 
-#include <map>
 #include <algorithm>
 #include <vector>
 #include <list>
@@ -10,6 +9,7 @@
 #include "comparator.h"
 #include "fleet.h"
 #include "player.h"
+#include "snapshot.h"
 
 using std::min;
 using std::vector;
@@ -70,7 +70,7 @@ Point Planet::coordinate() const
     return coordinate_m;
 }
 
-Planets Planet::closestPlanets() const
+Planets const& Planet::closestPlanets() const
 {
     return closestPlanets_m;
 }
@@ -94,10 +94,37 @@ void Planet::addLeavingFleet(Fleet* fleet)
     leavingFleets_m.push_back(fleet);
 }
 
+//merges the incoming fleets that arrive in the same turn and belong to the same player.
+//The predictions only care about how many ships of which player arrive when, so this is all they need to look at.
+void Planet::aggregateArrivals()
+{
+    arrivals_m.clear();
+    for (Fleets::const_iterator it = incomingFleets_m.begin(); it != incomingFleets_m.end(); ++it) {
+        const Fleet* f = *it;
+        std::vector<Fleet>::iterator arrival = arrivals_m.begin();
+        while (arrival != arrivals_m.end()
+               && (arrival->turnsRemaining() < f->turnsRemaining()
+                   || (arrival->turnsRemaining() == f->turnsRemaining() && arrival->owner() != f->owner()))) {
+            ++arrival;
+        }
+        if (arrival != arrivals_m.end() && arrival->turnsRemaining() == f->turnsRemaining()) {
+            *arrival = Fleet(f->owner(), 0, this, arrival->shipsCount() + f->shipsCount(), f->turnsRemaining(), f->turnsRemaining());
+        } else {
+            arrivals_m.insert(arrival, Fleet(f->owner(), 0, this, f->shipsCount(), f->turnsRemaining(), f->turnsRemaining()));
+        }
+    }
+}
+
+const std::vector<Fleet>& Planet::arrivals() const
+{
+    return arrivals_m;
+}
+
 void Planet::clearFleets()
 {
     leavingFleets_m.clear();
     incomingFleets_m.clear();
+    arrivals_m.clear();
 }
 
 int Planet::distance(const Planet* p)
@@ -135,56 +162,51 @@ vector <Planet> Planet::getPredictions(int t, list<Fleet> fs, int start)
     }
     predictions.push_back(p);
 
+    //the forces of the players by ID, and the players that took part in a battle so far
+    int participants[MaxPlayersCount];
+    const Player* sides[MaxPlayersCount] = {};
+    int playersCount = p.owner_m->playerID() + 1;
+    sides[p.owner_m->playerID()] = p.owner_m;
+    std::vector<Fleet>::const_iterator arrival = arrivals_m.begin();
     for(int i(1);i!=t+1;i++){
         if(!p.owner_m->isNeutral()){
             p.shipsCount_m += p.growthRate_m;
         }
-        std::map<const Player*,int> participants;
-        participants[p.owner_m] = p.shipsCount_m;
+        std::fill(participants, participants + MaxPlayersCount, 0);
+        participants[p.owner_m->playerID()] = p.shipsCount_m;
     
-        for (Fleets::iterator it = incomingFleets_m.begin(); it != incomingFleets_m.end(); ++it ) {
-            Fleet* f = *it;
-            int tr = f->turnsRemaining();
-            if (tr - start == i ) {
-                participants[f->owner()] += f->shipsCount();
+        //arrivals are sorted by arrival turn, so only the ones arriving now have to be looked at
+        for (; arrival != arrivals_m.end() && int(arrival->turnsRemaining()) - start <= i; ++arrival) {
+            if (int(arrival->turnsRemaining()) - start == i) {
+                uint id = arrival->owner()->playerID();
+                participants[id] += arrival->shipsCount();
+                sides[id] = arrival->owner();
+                playersCount = std::max<int>(playersCount, id + 1);
             }
         }
 
         for (list<Fleet>::iterator f = fs.begin(); f != fs.end(); ++f ) {
+            uint id = f->owner()->playerID();
             if (f->destinationPlanet()->planetID() == this->planetID() && f->turnsRemaining() - start == i ) {
-                participants[f->owner()] += f->shipsCount();
+                participants[id] += f->shipsCount();
+                sides[id] = f->owner();
+                playersCount = std::max<int>(playersCount, id + 1);
                 f = fs.erase(f);
                 if(f == fs.end())
                     break;
             } else if ( f->sourcePlanet()->planetID() == this->planetID() && f->turnsRemaining() - start -i == this->distance(f->destinationPlanet())){
-                participants[f->owner()] -= f->shipsCount();
+                participants[id] -= f->shipsCount();
+                sides[id] = f->owner();
+                playersCount = std::max<int>(playersCount, id + 1);
                 f = fs.erase(f);
                 if(f == fs.end())
                     break;
             }
         }
-    
-    
 
-        Fleet winner(0, 0);
-        Fleet second(0, 0);
-        for (std::map<const Player*,int>::iterator f = participants.begin(); f != participants.end(); ++f) {
-            if (f->second > second.shipsCount()) {
-                if(f->second > winner.shipsCount()) {
-                    second = winner;
-                    winner = Fleet(f->first, f->second);
-                } else {
-                    second = Fleet(f->first, f->second);
-                }
-            }
-        }
- 
-        if (winner.shipsCount() > second.shipsCount()) {
-            p.shipsCount_m = winner.shipsCount() - second.shipsCount();
-            p.owner_m = winner.owner();
-        } else {
-            p.shipsCount_m = 0;
-        }
+        int owner = p.owner_m->playerID();
+        resolveBattle(participants, playersCount, owner, p.shipsCount_m);
+        p.owner_m = sides[owner];
         predictions.push_back(p);
     }
     return predictions;
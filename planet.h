@@ -4,6 +4,7 @@
 #include "defines.h"
 #include "point2d.h"
 #include "stlastar.h"
+#include "fleet.h"
 
 #include <list>
 
@@ -23,7 +24,9 @@ public:
 
 
     Point coordinate() const;
-    Planets closestPlanets() const;
+    Planets const& closestPlanets() const;
+    // Incoming fleets merged by owner and arrival turn, sorted by turnsRemaining. Their source planet is not set.
+    const std::vector<Fleet>& arrivals() const;
 
 
     int distance(const Planet* p);
@@ -57,6 +60,7 @@ private:
     void setOtherPlanets(const Planets& planets);
     void addIncomingFleet(Fleet* fleet);
     void addLeavingFleet(Fleet* fleet);
+    void aggregateArrivals();
     void clearFleets();
 
     int planetID_m;
@@ -67,6 +71,7 @@ private:
     // Pointers to all other planets. Sorted by distance in ascending order.
     Planets closestPlanets_m;
     Fleets leavingFleets_m;
+    std::vector<Fleet> arrivals_m;
 
 };
 
@@ -0,0 +1,110 @@
+#include "planetset.h"
+
+#include <algorithm>
+
+PlanetSet::PlanetSet(int size) :
+    words_m((size + 63) / 64, 0),
+    size_m(size)
+{
+}
+
+void PlanetSet::resize(int size)
+{
+    size_m = size;
+    words_m.assign((size + 63) / 64, 0);
+}
+
+void PlanetSet::clear()
+{
+    std::fill(words_m.begin(), words_m.end(), 0);
+}
+
+bool PlanetSet::empty() const
+{
+    for (unsigned int i = 0; i < words_m.size(); ++i) {
+        if (words_m[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PlanetSet::intersects(const PlanetSet& planets) const
+{
+    for (unsigned int i = 0; i < words_m.size(); ++i) {
+        if (words_m[i] & planets.words_m[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int PlanetSet::next(int planetID) const
+{
+    if (planetID >= size_m) {
+        return -1;
+    }
+    unsigned int i = planetID >> 6;
+    unsigned long long word = words_m[i] & (~0ULL << (planetID & 63));
+    while (!word) {
+        if (++i == words_m.size()) {
+            return -1;
+        }
+        word = words_m[i];
+    }
+    return i * 64 + __builtin_ctzll(word);
+}
+
+PlanetSet& PlanetSet::operator&=(const PlanetSet& planets)
+{
+    for (unsigned int i = 0; i < words_m.size(); ++i) {
+        words_m[i] &= planets.words_m[i];
+    }
+    return *this;
+}
+
+PlanetSet& PlanetSet::operator|=(const PlanetSet& planets)
+{
+    for (unsigned int i = 0; i < words_m.size(); ++i) {
+        words_m[i] |= planets.words_m[i];
+    }
+    return *this;
+}
+
+PlanetSet& PlanetSet::operator-=(const PlanetSet& planets)
+{
+    for (unsigned int i = 0; i < words_m.size(); ++i) {
+        words_m[i] &= ~planets.words_m[i];
+    }
+    return *this;
+}
+
+PlanetSet PlanetSet::mapped(const std::vector<int>& mapping) const
+{
+    PlanetSet result(size_m);
+    for (int i = next(0); i >= 0; i = next(i + 1)) {
+        result.insert(mapping[i]);
+    }
+    return result;
+}
+
+void PlanetSet::toWords(const std::vector<PlanetSet>& sets, std::vector<unsigned long long>& words)
+{
+    words.clear();
+    for (std::vector<PlanetSet>::const_iterator it = sets.begin(); it != sets.end(); ++it) {
+        words.insert(words.end(), it->words_m.begin(), it->words_m.end());
+    }
+}
+
+bool PlanetSet::fromWords(const std::vector<unsigned long long>& words, int size, int count, std::vector<PlanetSet>& sets)
+{
+    unsigned int wordsPerSet = (size + 63) / 64;
+    if (words.size() != wordsPerSet * count) {
+        return false;
+    }
+    sets.assign(count, PlanetSet(size));
+    for (int i = 0; i < count; ++i) {
+        std::copy(words.begin() + i * wordsPerSet, words.begin() + (i + 1) * wordsPerSet, sets[i].words_m.begin());
+    }
+    return true;
+}
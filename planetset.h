@@ -0,0 +1,44 @@
+#ifndef PLANETSET_H
+#define PLANETSET_H
+
+#include <vector>
+
+// A set of planets, stored as a bitset indexed by planet ID.
+// Set operations work on 64 planets at a time.
+class PlanetSet {
+public:
+    PlanetSet(int size = 0);
+
+    // Number of planet IDs the set can hold, the set is emptied.
+    void resize(int size);
+    int size() const { return size_m; }
+
+    void clear();
+    void insert(int planetID) { words_m[planetID >> 6] |= 1ULL << (planetID & 63); }
+    void erase(int planetID) { words_m[planetID >> 6] &= ~(1ULL << (planetID & 63)); }
+    bool contains(int planetID) const { return (words_m[planetID >> 6] >> (planetID & 63)) & 1; }
+
+    bool empty() const;
+    bool intersects(const PlanetSet& planets) const;
+    // The smallest planet ID in the set that is not smaller than planetID, or -1.
+    int next(int planetID) const;
+
+    PlanetSet& operator&=(const PlanetSet& planets);
+    PlanetSet& operator|=(const PlanetSet& planets);
+    // Removes the given planets.
+    PlanetSet& operator-=(const PlanetSet& planets);
+
+    // The set of the planets that the given planets are mapped to, e.g. by Game::mirror().
+    PlanetSet mapped(const std::vector<int>& mapping) const;
+
+    // Stores a table of sets of the same size one after the other, e.g. for the map cache.
+    static void toWords(const std::vector<PlanetSet>& sets, std::vector<unsigned long long>& words);
+    // Restores count sets of the given size, returns false if the number of words doesn't fit.
+    static bool fromWords(const std::vector<unsigned long long>& words, int size, int count, std::vector<PlanetSet>& sets);
+
+private:
+    std::vector<unsigned long long> words_m;
+    int size_m;
+};
+
+#endif // PLANETSET_H
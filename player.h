@@ -6,6 +6,8 @@
 class Player
 {
     friend class Game;
+    friend class Snapshot;
+    friend class Planet;
 public:
     Player(uint playerID);
 
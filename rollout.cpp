@@ -0,0 +1,199 @@
+#include "rollout.h"
+
+#include <algorithm>
+#include <sys/time.h>
+
+static double now()
+{
+    timeval tim;
+    gettimeofday(&tim, NULL);
+    return tim.tv_sec + (tim.tv_usec / 1000000.0);
+}
+
+//xorshift, good enough for the policy and without shared state
+static unsigned int nextRandom(unsigned int& seed)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+//Every planet of a player sends half of its ships with a probability of 1/4, to the closer one of two random planets.
+static void policyMoves(const GameState& state, unsigned int& seed, GameState::Move* moves, int& movesCount)
+{
+    int n = state.planetsCount();
+    movesCount = 0;
+    for (int p = 0; p < n; ++p) {
+        if (state.owner(p) == NeutralID || state.shipsCount(p) < 2 || (nextRandom(seed) & 3) != 0) {
+            continue;
+        }
+        int target1 = nextRandom(seed) % n;
+        int target2 = nextRandom(seed) % n;
+        int target = state.distance(p, target1) <= state.distance(p, target2) ? target1 : target2;
+        if (target == p) {
+            continue;
+        }
+        GameState::Move& move = moves[movesCount++];
+        move.source = p;
+        move.destination = target;
+        move.shipsCount = state.shipsCount(p) / 2;
+    }
+}
+
+int RolloutEvaluator::rollout(GameState& state, const Moves& firstMoves, int depth, unsigned int seed)
+{
+    GameState::Move moves[GameState::MaxPlanets * 2];
+    seed |= 1;
+    for (int t = 0; t < depth && state.winner() < 0; ++t) {
+        int movesCount;
+        policyMoves(state, seed, moves, movesCount);
+        if (t == 0) {
+            //my moves of the first turn are the candidate, the enemy moves come from the policy
+            int enemyMovesCount = 0;
+            for (int i = 0; i < movesCount; ++i) {
+                if (state.owner(moves[i].source) != MyID) {
+                    moves[enemyMovesCount++] = moves[i];
+                }
+            }
+            movesCount = enemyMovesCount;
+            for (Moves::const_iterator m = firstMoves.begin(); m != firstMoves.end() && movesCount < GameState::MaxPlanets * 2; ++m) {
+                moves[movesCount++] = *m;
+            }
+        }
+        state.step(moves, movesCount);
+    }
+    return score(state, depth);
+}
+
+int RolloutEvaluator::score(const GameState& state, int turns)
+{
+    int strongest = state.playerShipsCount(EnemyID) + state.playerGrowthRate(EnemyID) * turns;
+    for (int player = EnemyID + 1; player < state.playersCount(); ++player) {
+        strongest = std::max(strongest, state.playerShipsCount(player) + state.playerGrowthRate(player) * turns);
+    }
+    return state.playerShipsCount(MyID) + state.playerGrowthRate(MyID) * turns - strongest;
+}
+
+
+RolloutEvaluator::RolloutEvaluator() :
+    stop_m(false),
+    generation_m(0),
+    busyThreads_m(0),
+    state_m(0),
+    candidates_m(0),
+    depth_m(0),
+    deadline_m(0),
+    tasksCount_m(0),
+    nextTask_m(0)
+{
+}
+
+RolloutEvaluator::~RolloutEvaluator()
+{
+    setThreadsCount(0);
+}
+
+void RolloutEvaluator::setThreadsCount(int threadsCount)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_m);
+        stop_m = true;
+    }
+    start_m.notify_all();
+    for (std::vector<std::thread>::iterator t = threads_m.begin(); t != threads_m.end(); ++t) {
+        t->join();
+    }
+    threads_m.clear();
+    //new threads wait for the next evaluation, the tasks of the last one point to a state that is gone
+    std::lock_guard<std::mutex> lock(mutex_m);
+    stop_m = false;
+    for (int i = 0; i < threadsCount; ++i) {
+        threads_m.push_back(std::thread(&RolloutEvaluator::work, this, generation_m));
+    }
+}
+
+int RolloutEvaluator::threadsCount() const
+{
+    return threads_m.size();
+}
+
+void RolloutEvaluator::work(int generation)
+{
+    std::unique_lock<std::mutex> lock(mutex_m);
+    while (true) {
+        start_m.wait(lock, [&] { return stop_m || generation_m != generation; });
+        if (stop_m) {
+            return;
+        }
+        generation = generation_m;
+        lock.unlock();
+        runTasks();
+        lock.lock();
+        if (--busyThreads_m == 0) {
+            finished_m.notify_all();
+        }
+    }
+}
+
+//takes tasks until all are done or the time is up, the results are added up at the end
+void RolloutEvaluator::runTasks()
+{
+    int candidatesCount = candidates_m->size();
+    std::vector<long long> scoreSums(candidatesCount, 0);
+    std::vector<int> counts(candidatesCount, 0);
+    GameState state;
+    while (true) {
+        int task;
+        {
+            std::lock_guard<std::mutex> lock(mutex_m);
+            if (nextTask_m == tasksCount_m || now() > deadline_m) {
+                break;
+            }
+            task = nextTask_m++;
+        }
+        int candidate = task % candidatesCount;
+        state = *state_m;
+        //the seed only depends on the task, so the result doesn't depend on the threads
+        scoreSums[candidate] += rollout(state, (*candidates_m)[candidate], depth_m, 2654435761u * (task / candidatesCount + 1));
+        ++counts[candidate];
+    }
+    std::lock_guard<std::mutex> lock(mutex_m);
+    for (int c = 0; c < candidatesCount; ++c) {
+        scoreSums_m[c] += scoreSums[c];
+        counts_m[c] += counts[c];
+    }
+}
+
+void RolloutEvaluator::evaluate(const GameState& state, const std::vector<Moves>& candidates, int rolloutsCount, int depth, double deadline,
+                                std::vector<double>& scores, std::vector<int>& counts)
+{
+    int candidatesCount = candidates.size();
+    scores.assign(candidatesCount, 0);
+    counts.assign(candidatesCount, 0);
+    if (candidatesCount == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_m);
+        state_m = &state;
+        candidates_m = &candidates;
+        depth_m = depth;
+        deadline_m = deadline;
+        tasksCount_m = candidatesCount * rolloutsCount;
+        nextTask_m = 0;
+        scoreSums_m.assign(candidatesCount, 0);
+        counts_m.assign(candidatesCount, 0);
+        //every worker takes part in every evaluation, even if only to find that there is nothing left to do
+        busyThreads_m = threads_m.size();
+        ++generation_m;
+    }
+    start_m.notify_all();
+    runTasks();
+    std::unique_lock<std::mutex> lock(mutex_m);
+    finished_m.wait(lock, [&] { return busyThreads_m == 0; });
+    for (int c = 0; c < candidatesCount; ++c) {
+        counts[c] = counts_m[c];
+        scores[c] = counts_m[c] > 0 ? double(scoreSums_m[c]) / counts_m[c] : 0;
+    }
+}
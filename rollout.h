@@ -0,0 +1,62 @@
+#ifndef ROLLOUT_H
+#define ROLLOUT_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "gamestate.h"
+
+// Scores candidate moves by playing the game forward from the current state a number of times.
+// In the first turn I make the candidate moves, after that all players follow a fast randomized policy.
+// The score of a rollout is the difference in ships between me and the strongest enemy at the end, with the
+// difference in growth rate counted for the turns played. The rollouts run on a pool of threads.
+class RolloutEvaluator {
+public:
+    typedef std::vector<GameState::Move> Moves;
+
+    RolloutEvaluator();
+    ~RolloutEvaluator();
+
+    // Number of worker threads, the calling thread always takes part. 0 runs all rollouts in the calling thread.
+    void setThreadsCount(int threadsCount);
+    int threadsCount() const;
+
+    // Plays up to rolloutsCount rollouts of the given depth for each candidate, but stops at the deadline,
+    // in seconds since the epoch like gettimeofday(). The candidates take turns, so they get the same number
+    // of rollouts up to one. Returns the mean score and the number of rollouts of each candidate.
+    void evaluate(const GameState& state, const std::vector<Moves>& candidates, int rolloutsCount, int depth, double deadline,
+                  std::vector<double>& scores, std::vector<int>& counts);
+
+    // One rollout, the state is played forward in place. Returns its score for MyID.
+    static int rollout(GameState& state, const Moves& firstMoves, int depth, unsigned int seed);
+    // The score of a state for MyID against the strongest enemy, with the growth rates counted for the given number of turns.
+    static int score(const GameState& state, int turns);
+
+private:
+    void work(int generation);
+    void runTasks();
+
+    std::vector<std::thread> threads_m;
+    std::mutex mutex_m;
+    std::condition_variable start_m;
+    std::condition_variable finished_m;
+    bool stop_m;
+    // incremented for every evaluation, the workers wait for it to change
+    int generation_m;
+    // workers that have not finished the current evaluation
+    int busyThreads_m;
+
+    // the current evaluation
+    const GameState* state_m;
+    const std::vector<Moves>* candidates_m;
+    int depth_m;
+    double deadline_m;
+    int tasksCount_m;
+    int nextTask_m;
+    std::vector<long long> scoreSums_m;
+    std::vector<int> counts_m;
+};
+
+#endif // ROLLOUT_H
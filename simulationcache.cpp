@@ -0,0 +1,148 @@
+#include "simulationcache.h"
+
+//random numbers for the hashes, generated by splitmix64 so they are the same in every run
+static uint64_t splitmix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+namespace {
+    // Zobrist tables, indexed by the low bits of the planet, the turn and the owner of an event.
+    // There is an entry for every player ID, the sizes are powers of two.
+    struct ZobristTables {
+        enum {
+            Planets = 256,
+            Turns = 256,
+            Owners = 16
+        };
+        uint64_t planets[2][Planets];
+        uint64_t events[2][Turns][Owners];
+
+        ZobristTables() {
+            uint64_t state = 20110817;
+            for (int h = 0; h < 2; ++h) {
+                for (int p = 0; p < Planets; ++p) {
+                    planets[h][p] = splitmix64(state);
+                }
+                for (int t = 0; t < Turns; ++t) {
+                    for (int o = 0; o < Owners; ++o) {
+                        events[h][t][o] = splitmix64(state);
+                    }
+                }
+            }
+        }
+    };
+
+    const ZobristTables zobrist;
+}
+
+//mixes a value into a hash, for the parts that are not covered by the tables
+static uint64_t mix(uint64_t hash, uint64_t value)
+{
+    uint64_t state = hash ^ value;
+    return splitmix64(state);
+}
+
+SimulationCache::SimulationCache() :
+    buckets_m(BucketsCount),
+    generation_m(1),
+    slotSize_m(0),
+    lookups_m(0),
+    hits_m(0)
+{
+    for (std::vector<Bucket>::iterator b = buckets_m.begin(); b != buckets_m.end(); ++b) {
+        for (int e = 0; e < EntriesPerBucket; ++e) {
+            b->entries[e].generation = 0;
+        }
+        b->newest = 0;
+    }
+}
+
+void SimulationCache::clear()
+{
+    ++generation_m;
+}
+
+void SimulationCache::resetStatistics()
+{
+    lookups_m = 0;
+    hits_m = 0;
+}
+
+SimulationCache::Key SimulationCache::key(int planet, int version, int turns, const FleetEvents& events)
+{
+    Key key;
+    uint64_t* hashes[2] = { &key.hash1, &key.hash2 };
+    for (int h = 0; h < 2; ++h) {
+        uint64_t hash = zobrist.planets[h][planet & (ZobristTables::Planets - 1)];
+        //every event is hashed by mix() from the Zobrist key of its turn and owner together with its turn and ship count,
+        //and the hashes are added up so the order of the events does not matter
+        uint64_t sum = 0;
+        for (FleetEvents::const_iterator e = events.begin(); e != events.end(); ++e) {
+            uint64_t eventHash = zobrist.events[h][e->turn & (ZobristTables::Turns - 1)][e->owner & (ZobristTables::Owners - 1)];
+            sum += mix(eventHash, (uint64_t(uint32_t(e->turn)) << 32) | uint32_t(e->shipsCount));
+        }
+        hash = mix(hash, sum);
+        hash = mix(hash, (uint64_t(uint32_t(planet)) << 32) | uint32_t(version));
+        hash = mix(hash, (uint64_t(uint32_t(turns)) << 32) | uint32_t(events.size()));
+        *hashes[h] = hash;
+    }
+    return key;
+}
+
+bool SimulationCache::find(const Key& key, Timeline& timeline)
+{
+    ++lookups_m;
+    Bucket& bucket = buckets_m[key.hash1 & (BucketsCount - 1)];
+    for (int e = 0; e < EntriesPerBucket; ++e) {
+        const Entry& entry = bucket.entries[e];
+        if (entry.generation == generation_m && entry.hash1 == key.hash1 && entry.hash2 == key.hash2) {
+            int slot = (key.hash1 & (BucketsCount - 1)) * EntriesPerBucket + e;
+            const int* owners = &owners_m[slot * slotSize_m];
+            const int* shipsCounts = &shipsCounts_m[slot * slotSize_m];
+            timeline.resize(entry.size);
+            for (int t = 0; t < entry.size; ++t) {
+                timeline.set(t, owners[t], shipsCounts[t]);
+            }
+            ++hits_m;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SimulationCache::insert(const Key& key, const Timeline& timeline)
+{
+    int size = timeline.size();
+    if (size > slotSize_m) {
+        //longer timelines than before, the slots grow and the old entries are dropped
+        slotSize_m = size;
+        owners_m.assign(BucketsCount * EntriesPerBucket * slotSize_m, 0);
+        shipsCounts_m.assign(BucketsCount * EntriesPerBucket * slotSize_m, 0);
+        clear();
+    }
+    Bucket& bucket = buckets_m[key.hash1 & (BucketsCount - 1)];
+    int e = 1 - bucket.newest;
+    for (int i = 0; i < EntriesPerBucket; ++i) {
+        if (bucket.entries[i].generation != generation_m) {
+            e = i;
+            break;
+        }
+    }
+    Entry& entry = bucket.entries[e];
+    entry.hash1 = key.hash1;
+    entry.hash2 = key.hash2;
+    entry.generation = generation_m;
+    entry.size = size;
+    bucket.newest = e;
+    int slot = (key.hash1 & (BucketsCount - 1)) * EntriesPerBucket + e;
+    int* owners = &owners_m[slot * slotSize_m];
+    int* shipsCounts = &shipsCounts_m[slot * slotSize_m];
+    for (int t = 0; t < size; ++t) {
+        owners[t] = timeline.owner(t);
+        shipsCounts[t] = timeline.shipsCount(t);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef SIMULATIONCACHE_H
+#define SIMULATIONCACHE_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "snapshot.h"
+
+// Remembers the timelines of planet simulations with hypothetical fleets, so that the same simulation
+// within a turn is only run once. A simulation is identified by a Zobrist hash of the planet, its state, the number
+// of turns and the events. The hashes of the events are added up, so their order doesn't matter.
+// Two independent 64 bit hashes are kept, collisions are not checked for.
+// The table has a fixed size with two entries per cache line, a new entry replaces the older one of its bucket.
+// Clearing only starts a new generation, the entries of older generations count as empty.
+class SimulationCache {
+public:
+    SimulationCache();
+
+    void clear();
+
+    struct Key {
+        uint64_t hash1;
+        uint64_t hash2;
+    };
+    // version identifies the state of the planet, it changes whenever ships or fleets are added to the planet
+    static Key key(int planet, int version, int turns, const FleetEvents& events);
+
+    bool find(const Key& key, Timeline& timeline);
+    void insert(const Key& key, const Timeline& timeline);
+
+    long lookups() const { return lookups_m; }
+    long hits() const { return hits_m; }
+    void resetStatistics();
+
+private:
+    enum {
+        BucketsCount = 2048,
+        EntriesPerBucket = 2
+    };
+
+    struct Entry {
+        uint64_t hash1;
+        uint64_t hash2;
+        uint32_t generation;
+        int32_t size;
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[EntriesPerBucket];
+        // the entry that was written last
+        int newest;
+    };
+
+    std::vector<Bucket> buckets_m;
+    uint32_t generation_m;
+    // the timelines of the entries, each in a slot of slotSize_m turns
+    int slotSize_m;
+    std::vector<int> owners_m;
+    std::vector<int> shipsCounts_m;
+
+    long lookups_m;
+    long hits_m;
+};
+
+#endif // SIMULATIONCACHE_H
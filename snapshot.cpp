@@ -0,0 +1,287 @@
+#include "snapshot.h"
+
+#include <algorithm>
+
+#include "fleet.h"
+#include "planet.h"
+#include "player.h"
+#include "point2d.h"
+#include "simulationcache.h"
+
+using std::max;
+using std::vector;
+
+void Timeline::resize(int size)
+{
+    owner_m.resize(size);
+    shipsCount_m.resize(size);
+}
+
+void Timeline::set(int t, int owner, int shipsCount)
+{
+    owner_m[t] = owner;
+    shipsCount_m[t] = shipsCount;
+}
+
+
+//Forces are compared as unsigned numbers like the ships counts of fleets, so a garrison that went negative
+//because more ships were sent away than available stays with its owner as a negative ships count.
+void resolveBattle(const int* participants, int playersCount, int& owner, int& shipsCount)
+{
+    int winner = 0;
+    uint winnerShips = 0;
+    uint secondShips = 0;
+    for (int i = 0; i < playersCount; ++i) {
+        uint sc = participants[i];
+        if (sc > secondShips) {
+            if (sc > winnerShips) {
+                secondShips = winnerShips;
+                winnerShips = sc;
+                winner = i;
+            } else {
+                secondShips = sc;
+            }
+        }
+    }
+    if (winnerShips > secondShips) {
+        shipsCount = winnerShips - secondShips;
+        owner = winner;
+    } else {
+        shipsCount = 0;
+    }
+}
+
+
+Snapshot::Snapshot() :
+    playersCount_m(3),
+    stateVersion_m(0),
+    lastVersion_m(0),
+    simulationCache_m(new SimulationCache()),
+    caching_m(true)
+{
+}
+
+Snapshot::~Snapshot()
+{
+    delete simulationCache_m;
+}
+
+void Snapshot::update(const Planets& planets)
+{
+    uint planetsCount = planets.size();
+    bool newMap = distances_m.size() != planetsCount * planetsCount;
+
+    planetOwner.resize(planetsCount);
+    planetShips.resize(planetsCount);
+    planetGrowth.resize(planetsCount);
+    planetX.resize(planetsCount);
+    planetY.resize(planetsCount);
+    arrivalsBegin.resize(planetsCount + 1);
+    planetVersion_m.assign(planetsCount, 0);
+    lastVersion_m = 0;
+    ++stateVersion_m;
+    addedOrders_m.clear();
+    simulationCache_m->clear();
+    simulationCache_m->resetStatistics();
+    fleetOwner.clear();
+    fleetDestination.clear();
+    fleetArrival.clear();
+    fleetShips.clear();
+
+    playersCount_m = 3;
+    for (uint i = 0; i < planetsCount; ++i) {
+        const Planet* p = planets[i];
+        planetOwner[i] = p->owner()->playerID();
+        planetShips[i] = p->shipsCount();
+        planetGrowth[i] = p->growthRate();
+        planetX[i] = p->coordinate().x();
+        planetY[i] = p->coordinate().y();
+        playersCount_m = max(playersCount_m, planetOwner[i] + 1);
+
+        arrivalsBegin[i] = fleetOwner.size();
+        const vector<Fleet>& arrivals = p->arrivals();
+        for (vector<Fleet>::const_iterator f = arrivals.begin(); f != arrivals.end(); ++f) {
+            fleetOwner.push_back(f->owner()->playerID());
+            fleetDestination.push_back(i);
+            fleetArrival.push_back(f->turnsRemaining());
+            fleetShips.push_back(f->shipsCount());
+            playersCount_m = max(playersCount_m, fleetOwner.back() + 1);
+        }
+    }
+    arrivalsBegin[planetsCount] = fleetOwner.size();
+
+    if (newMap) {
+        computeDistances();
+    }
+}
+
+void Snapshot::setCaching(bool enabled)
+{
+    caching_m = enabled;
+}
+
+void Snapshot::setDistances(const vector<int>& distances)
+{
+    distances_m = distances;
+}
+
+void Snapshot::computeDistances()
+{
+    int n = planetsCount();
+    distances_m.resize(n * n);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            distances_m[i * n + j] = Point::distanceBetween(Point(planetX[i], planetY[i]), Point(planetX[j], planetY[j]));
+        }
+    }
+}
+
+//does to the snapshot what Game::issueOrder() does to the game
+void Snapshot::addOrder(int sourceID, int destinationID, int shipsCount)
+{
+    int owner = planetOwner[sourceID];
+    int arrival = distance(sourceID, destinationID);
+    AddedOrder added = { sourceID, destinationID, shipsCount, 0, false, planetVersion_m[sourceID], planetVersion_m[destinationID] };
+    planetShips[sourceID] -= shipsCount;
+    ++stateVersion_m;
+    planetVersion_m[sourceID] = ++lastVersion_m;
+    planetVersion_m[destinationID] = ++lastVersion_m;
+
+    int f = arrivalsBegin[destinationID];
+    int end = arrivalsBegin[destinationID + 1];
+    while (f != end && (fleetArrival[f] < arrival || (fleetArrival[f] == arrival && fleetOwner[f] != owner))) {
+        ++f;
+    }
+    added.fleet = f;
+    addedOrders_m.push_back(added);
+    if (f != end && fleetArrival[f] == arrival) {
+        fleetShips[f] += shipsCount;
+        return;
+    }
+    addedOrders_m.back().newFleet = true;
+    fleetOwner.insert(fleetOwner.begin() + f, owner);
+    fleetDestination.insert(fleetDestination.begin() + f, destinationID);
+    fleetArrival.insert(fleetArrival.begin() + f, arrival);
+    fleetShips.insert(fleetShips.begin() + f, shipsCount);
+    for (int i = destinationID + 1; i < int(arrivalsBegin.size()); ++i) {
+        ++arrivalsBegin[i];
+    }
+}
+
+void Snapshot::undoOrder()
+{
+    const AddedOrder& added = addedOrders_m.back();
+    planetShips[added.sourceID] += added.shipsCount;
+    ++stateVersion_m;
+    planetVersion_m[added.sourceID] = added.sourceVersion;
+    planetVersion_m[added.destinationID] = added.destinationVersion;
+    if (added.newFleet) {
+        fleetOwner.erase(fleetOwner.begin() + added.fleet);
+        fleetDestination.erase(fleetDestination.begin() + added.fleet);
+        fleetArrival.erase(fleetArrival.begin() + added.fleet);
+        fleetShips.erase(fleetShips.begin() + added.fleet);
+        for (int i = added.destinationID + 1; i < int(arrivalsBegin.size()); ++i) {
+            --arrivalsBegin[i];
+        }
+    } else {
+        fleetShips[added.fleet] -= added.shipsCount;
+    }
+    addedOrders_m.pop_back();
+}
+
+//sums up the ships of the events per turn and player, so the simulation can look them up directly
+int* Snapshot::extraShips(int turns, const FleetEvents& events) const
+{
+    extraShips_m.assign((turns + 1) * playersCount_m, 0);
+    for (FleetEvents::const_iterator e = events.begin(); e != events.end(); ++e) {
+        if (e->turn > 0 && e->turn <= turns) {
+            extraShips_m[e->turn * playersCount_m + e->owner] += e->shipsCount;
+        }
+    }
+    return &extraShips_m[0];
+}
+
+void Snapshot::simulate(int planet, int turns, Timeline& timeline) const
+{
+    static const FleetEvents noEvents;
+    simulate(planet, turns, noEvents, timeline);
+}
+
+void Snapshot::simulate(int planet, int turns, const FleetEvents& events, Timeline& timeline) const
+{
+    SimulationCache::Key key;
+    if (caching_m) {
+        key = SimulationCache::key(planet, planetVersion_m[planet], turns, events);
+        if (simulationCache_m->find(key, timeline)) {
+            return;
+        }
+    }
+    int owner = planetOwner[planet];
+    int shipsCount = planetShips[planet];
+    int growthRate = planetGrowth[planet];
+    for (FleetEvents::const_iterator e = events.begin(); e != events.end(); ++e) {
+        if (e->turn == 0) {
+            shipsCount -= e->shipsCount;
+        }
+    }
+    timeline.resize(turns + 1);
+    timeline.set(0, owner, shipsCount);
+
+    const int* extra = extraShips(turns, events);
+    int participants[MaxPlayersCount];
+    int f = arrivalsBegin[planet];
+    int end = arrivalsBegin[planet + 1];
+    for (int t = 1; t <= turns; ++t) {
+        if (owner != NeutralID) {
+            shipsCount += growthRate;
+        }
+        for (int i = 0; i < playersCount_m; ++i) {
+            participants[i] = extra[t * playersCount_m + i];
+        }
+        participants[owner] += shipsCount;
+        for (; f != end && fleetArrival[f] <= t; ++f) {
+            if (fleetArrival[f] == t) {
+                participants[fleetOwner[f]] += fleetShips[f];
+            }
+        }
+        resolveBattle(participants, playersCount_m, owner, shipsCount);
+        timeline.set(t, owner, shipsCount);
+    }
+    if (caching_m) {
+        simulationCache_m->insert(key, timeline);
+    }
+}
+
+void Snapshot::simulateMaxOutgoing(int planet, int turns, Timeline& outgoing) const
+{
+    int owner = planetOwner[planet];
+    int shipsCount = planetShips[planet];
+    int growthRate = planetGrowth[planet];
+    outgoing.resize(turns + 1);
+
+    int participants[MaxPlayersCount];
+    int f = arrivalsBegin[planet];
+    int end = arrivalsBegin[planet + 1];
+    for (int t = 0; t <= turns; ++t) {
+        if (t > 0) {
+            if (owner != NeutralID) {
+                shipsCount += growthRate;
+            }
+            std::fill(participants, participants + playersCount_m, 0);
+            participants[owner] = shipsCount;
+            for (; f != end && fleetArrival[f] <= t; ++f) {
+                if (fleetArrival[f] == t) {
+                    participants[fleetOwner[f]] += fleetShips[f];
+                }
+            }
+            resolveBattle(participants, playersCount_m, owner, shipsCount);
+        }
+        //neutral planets don't send ships
+        if (owner != NeutralID) {
+            outgoing.set(t, owner, shipsCount);
+            shipsCount = 0;
+        } else {
+            outgoing.set(t, owner, 0);
+        }
+    }
+}
@@ -0,0 +1,142 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+
+#include "defines.h"
+
+class SimulationCache;
+
+// Player IDs as they appear in the snapshot
+enum {
+    NeutralID = 0,
+    MyID = 1,
+    EnemyID = 2
+};
+
+// Up to 8 players besides the neutral one, so a battle has at most this many sides
+enum {
+    MaxPlayersCount = 9
+};
+
+// Ships of one player that arrive at a planet in the given turn, on top of the fleets already in flight.
+// Events in turn 0 are ships leaving the planet right now.
+struct FleetEvent {
+    int turn;
+    int owner;
+    int shipsCount;
+};
+
+typedef std::vector<FleetEvent> FleetEvents;
+
+// The battle rules of the game, for the forces of each player at a planet including the garrison.
+// The largest force wins and keeps the difference to the second largest, on a tie the planet keeps its owner with no ships left.
+void resolveBattle(const int* participants, int playersCount, int& owner, int& shipsCount);
+
+// The predicted owner and ships count of one planet, one entry per turn starting with the current turn.
+class Timeline {
+public:
+    int size() const { return owner_m.size(); }
+
+    int owner(int t) const { return owner_m[t]; }
+    int shipsCount(int t) const { return shipsCount_m[t]; }
+
+    bool isMine(int t) const { return owner_m[t] == MyID; }
+    bool isNeutral(int t) const { return owner_m[t] == NeutralID; }
+    bool isEnemy(int t) const { return owner_m[t] > MyID; }
+
+    void resize(int size);
+    void set(int t, int owner, int shipsCount);
+
+private:
+    std::vector<int> owner_m;
+    std::vector<int> shipsCount_m;
+};
+
+// A flat copy of the planets and fleets of the game, kept in arrays indexed by planet ID.
+// It is rebuilt once per turn and patched with the orders issued during the turn.
+// All planet timeline simulations run on it.
+class Snapshot {
+public:
+    Snapshot();
+    ~Snapshot();
+
+    void update(const Planets& planets);
+    void addOrder(int sourceID, int destinationID, int shipsCount);
+    // Takes back the last order added since the last update().
+    void undoOrder();
+
+    // Changes with every update(), addOrder() and undoOrder(), so results computed from the snapshot can be
+    // kept as long as it stays the same
+    int stateVersion() const { return stateVersion_m; }
+
+    int planetsCount() const { return planetOwner.size(); }
+    int playersCount() const { return playersCount_m; }
+    int distance(int planet1, int planet2) const { return distances_m[planet1 * planetsCount() + planet2]; }
+    // The distance matrix, indexed by planet1 * planetsCount() + planet2.
+    // It is computed by the first update() unless it was set before.
+    const std::vector<int>& distances() const { return distances_m; }
+    void setDistances(const std::vector<int>& distances);
+
+    // Simulates the planet for the given number of turns, with the fleets in flight and the given events.
+    // The results are cached until the next update().
+    void simulate(int planet, int turns, const FleetEvents& events, Timeline& timeline) const;
+    void simulate(int planet, int turns, Timeline& timeline) const;
+    // Like simulate(), but whoever owns the planet sends away all ships in every turn.
+    // The result is the number of ships the planet can send in each turn.
+    void simulateMaxOutgoing(int planet, int turns, Timeline& outgoing) const;
+    const SimulationCache& simulationCache() const { return *simulationCache_m; }
+    // The cache is on by default, benchmarks of the simulation itself turn it off.
+    void setCaching(bool enabled);
+
+    // Planets
+    std::vector<int> planetOwner;
+    std::vector<int> planetShips;
+    std::vector<int> planetGrowth;
+    std::vector<double> planetX;
+    std::vector<double> planetY;
+
+    // Fleets in flight, merged by owner and arrival turn and sorted by destination and arrival.
+    // The fleets arriving at planet p are [arrivalsBegin[p], arrivalsBegin[p+1]).
+    std::vector<int> fleetOwner;
+    std::vector<int> fleetDestination;
+    std::vector<int> fleetArrival;
+    std::vector<int> fleetShips;
+    std::vector<int> arrivalsBegin;
+
+private:
+    Snapshot(const Snapshot&);
+    Snapshot& operator=(const Snapshot&);
+
+    void computeDistances();
+    int* extraShips(int turns, const FleetEvents& events) const;
+
+    int playersCount_m;
+    int stateVersion_m;
+    std::vector<int> distances_m;
+
+    // Set to a new number by addOrder() for the planets whose ships or fleets change, part of the keys of the simulation cache.
+    // undoOrder() sets the numbers back, so the cached simulations of the earlier state are found again.
+    std::vector<int> planetVersion_m;
+    int lastVersion_m;
+
+    // What undoOrder() needs to know about an order
+    struct AddedOrder {
+        int sourceID;
+        int destinationID;
+        int shipsCount;
+        // index of the fleet the ships were added to
+        int fleet;
+        bool newFleet;
+        int sourceVersion;
+        int destinationVersion;
+    };
+    std::vector<AddedOrder> addedOrders_m;
+    SimulationCache* simulationCache_m;
+    bool caching_m;
+
+    // Scratch space for the simulations
+    mutable std::vector<int> extraShips_m;
+};
+
+#endif // SNAPSHOT_H